@@ -0,0 +1,675 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <zlib.h>
+#if NFI_ZSTD
+#include <zstd.h>
+#endif // NFI_ZSTD
+
+#include "common.h"
+
+#include "Compression.h"
+
+Compression::type_t Compression::Detect(const unsigned char * head, size_t size)
+{
+	static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+	static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+	if((sizeof(gzipMagic) <= size) && (0 == memcmp(head, gzipMagic, sizeof(gzipMagic))))
+	{
+		return COMPRESSION_GZIP;
+	}
+
+	if((sizeof(zstdMagic) <= size) && (0 == memcmp(head, zstdMagic, sizeof(zstdMagic))))
+	{
+		return COMPRESSION_ZSTD;
+	}
+
+	return COMPRESSION_NONE;
+}
+
+const char * Compression::Name(type_t type)
+{
+	static const char * const names[COMPRESSION_NROF + 1] = {"none", "gzip", "zstd", "unknown"};
+
+	return names[(COMPRESSION_NROF > type) ? type : COMPRESSION_NROF];
+}
+
+Decompressor::~Decompressor()
+{
+	if(Worker_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex_);
+			Stop_ = true;
+		}
+
+		Cond_.notify_all();
+		Worker_.join();
+	}
+}
+
+ssize_t Decompressor::RawRead(unsigned char * buffer, size_t size)
+{
+	while(true)
+	{
+		const ssize_t readRet = read(Fd_, buffer, size);
+		if((0 > readRet) && (EINTR == errno))
+		{
+			continue;
+		}
+
+		if(0 > readRet)
+		{
+			nfiError("Could not read %s\n", Name_);
+		}
+
+		return readRet;
+	}
+}
+
+int Decompressor::Open(int fd, const char * name)
+{
+	Fd_ = fd;
+	Name_ = name;
+
+	// Pipes can't seek back, so the magic number is kept and returned first
+	while(HeadSize_ < sizeof(Head_))
+	{
+		const ssize_t readRet = RawRead(Head_ + HeadSize_, sizeof(Head_) - HeadSize_);
+		if(0 > readRet)
+		{
+			return -1;
+		}
+		else if(0 == readRet)
+		{
+			break;
+		}
+
+		HeadSize_ += readRet;
+	}
+
+	Type_ = Compression::Detect(Head_, HeadSize_);
+
+#if !NFI_ZSTD
+	if(Compression::COMPRESSION_ZSTD == Type_)
+	{
+		nfiError("%s is zstd compressed, but zstd support is not built in (make ZSTD=1)\n", Name_);
+		return -1;
+	}
+#endif // !NFI_ZSTD
+
+	if(Compression::COMPRESSION_NONE != Type_)
+	{
+		Worker_ = std::thread([this, diagnostics = nfiDiagnostics]() { nfiDiagnostics = diagnostics; Work(); });
+	}
+
+	return 0;
+}
+
+ssize_t Decompressor::Read(char * buffer, size_t size)
+{
+	if(Compression::COMPRESSION_NONE == Type_)
+	{
+		if(HeadPos_ < HeadSize_)
+		{
+			const size_t headCnt = std::min(size, HeadSize_ - HeadPos_);
+			memcpy(buffer, Head_ + HeadPos_, headCnt);
+			HeadPos_ += headCnt;
+			return headCnt;
+		}
+
+		return RawRead((unsigned char *) buffer, size);
+	}
+
+	if(Current_.size() == CurrentPos_)
+	{
+		std::unique_lock<std::mutex> lock(Mutex_);
+		Cond_.wait(lock, [this]() { return !Chunks_.empty() || Done_; });
+
+		if(Chunks_.empty())
+		{
+			return Failed_ ? -1 : 0;
+		}
+
+		Current_ = std::move(Chunks_.front());
+		Chunks_.erase(Chunks_.begin());
+		CurrentPos_ = 0;
+
+		lock.unlock();
+		Cond_.notify_all();
+	}
+
+	const size_t cnt = std::min(size, Current_.size() - CurrentPos_);
+	memcpy(buffer, Current_.data() + CurrentPos_, cnt);
+	CurrentPos_ += cnt;
+
+	return cnt;
+}
+
+ssize_t Decompressor::ReadFull(char * buffer, size_t size)
+{
+	size_t done = 0;
+	while(done < size)
+	{
+		const ssize_t readRet = Read(buffer + done, size - done);
+		if(0 > readRet)
+		{
+			return -1;
+		}
+		else if(0 == readRet)
+		{
+			break;
+		}
+
+		done += readRet;
+	}
+
+	return done;
+}
+
+void Decompressor::Work()
+{
+	const int ret = (Compression::COMPRESSION_GZIP == Type_) ? GzipDecompress() : ZstdDecompress();
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex_);
+		Failed_ = (0 != ret);
+		Done_ = true;
+	}
+
+	Cond_.notify_all();
+}
+
+// Blocks while MaxChunks_ chunks wait to be read
+int Decompressor::ChunkPush(std::vector<char> &&chunk)
+{
+	{
+		std::unique_lock<std::mutex> lock(Mutex_);
+		Cond_.wait(lock, [this]() { return (MaxChunks_ > Chunks_.size()) || Stop_; });
+
+		if(Stop_)
+		{
+			return -1;
+		}
+
+		Chunks_.push_back(std::move(chunk));
+	}
+
+	Cond_.notify_all();
+
+	return 0;
+}
+
+int Decompressor::GzipDecompress()
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if(Z_OK != inflateInit2(&stream, 16 + MAX_WBITS)) // gzip header
+	{
+		nfiError("inflateInit2 failed for %s\n", Name_);
+		return -1;
+	}
+
+	std::vector<unsigned char> in(Compression::ChunkSize);
+	std::vector<char> out(Compression::ChunkSize);
+	size_t outSize = 0;
+
+	stream.next_in = Head_;
+	stream.avail_in = HeadSize_;
+
+	bool inEnd = false;
+	bool memberEnd = false; // e.g. of pigz, several members may follow each other
+	int ret = 0;
+	while(true)
+	{
+		if((0 == stream.avail_in) && !inEnd)
+		{
+			const ssize_t readRet = RawRead(in.data(), in.size());
+			if(0 > readRet)
+			{
+				ret = -1;
+				break;
+			}
+
+			inEnd = (0 == readRet);
+			stream.next_in = in.data();
+			stream.avail_in = readRet;
+		}
+
+		if(0 == stream.avail_in)
+		{
+			if(!memberEnd)
+			{
+				nfiError("%s ends within its gzip stream\n", Name_);
+				ret = -1;
+			}
+			break;
+		}
+
+		stream.next_out = (unsigned char *) out.data() + outSize;
+		stream.avail_out = out.size() - outSize;
+
+		const int zRet = inflate(&stream, Z_NO_FLUSH);
+		outSize = out.size() - stream.avail_out;
+
+		if(Z_STREAM_END == zRet)
+		{
+			memberEnd = true;
+			inflateReset(&stream);
+		}
+		else if(Z_OK == zRet)
+		{
+			memberEnd = false;
+		}
+		else
+		{
+			nfiError("inflate failed for %s: %s\n", Name_, (nullptr != stream.msg) ? stream.msg : "");
+			ret = -1;
+			break;
+		}
+
+		if(out.size() == outSize)
+		{
+			if(ChunkPush(std::move(out)))
+			{
+				ret = -1;
+				break;
+			}
+
+			out = std::vector<char>(Compression::ChunkSize);
+			outSize = 0;
+		}
+	}
+
+	inflateEnd(&stream);
+
+	if((0 == ret) && (0 < outSize))
+	{
+		out.resize(outSize);
+		ret = ChunkPush(std::move(out));
+	}
+
+	return ret;
+}
+
+int Decompressor::ZstdDecompress()
+{
+#if NFI_ZSTD
+	ZSTD_DStream * stream = ZSTD_createDStream();
+	if(nullptr == stream)
+	{
+		nfiError("ZSTD_createDStream failed for %s\n", Name_);
+		return -1;
+	}
+
+	std::vector<unsigned char> in(Compression::ChunkSize);
+	std::vector<char> out(Compression::ChunkSize);
+	size_t outSize = 0;
+
+	ZSTD_inBuffer input = {Head_, HeadSize_, 0};
+
+	bool inEnd = false;
+	bool frameEnd = false; // several frames may follow each other
+	int ret = 0;
+	while(true)
+	{
+		if((input.size == input.pos) && !inEnd)
+		{
+			const ssize_t readRet = RawRead(in.data(), in.size());
+			if(0 > readRet)
+			{
+				ret = -1;
+				break;
+			}
+
+			inEnd = (0 == readRet);
+			input = {in.data(), (size_t) readRet, 0};
+		}
+
+		if(input.size == input.pos)
+		{
+			if(!frameEnd)
+			{
+				nfiError("%s ends within its zstd stream\n", Name_);
+				ret = -1;
+			}
+			break;
+		}
+
+		ZSTD_outBuffer output = {out.data(), out.size(), outSize};
+		const size_t zRet = ZSTD_decompressStream(stream, &output, &input);
+		if(ZSTD_isError(zRet))
+		{
+			nfiError("ZSTD_decompressStream failed for %s: %s\n", Name_, ZSTD_getErrorName(zRet));
+			ret = -1;
+			break;
+		}
+
+		outSize = output.pos;
+		frameEnd = (0 == zRet);
+
+		if(out.size() == outSize)
+		{
+			if(ChunkPush(std::move(out)))
+			{
+				ret = -1;
+				break;
+			}
+
+			out = std::vector<char>(Compression::ChunkSize);
+			outSize = 0;
+		}
+	}
+
+	ZSTD_freeDStream(stream);
+
+	if((0 == ret) && (0 < outSize))
+	{
+		out.resize(outSize);
+		ret = ChunkPush(std::move(out));
+	}
+
+	return ret;
+#else // !NFI_ZSTD
+	return -1; // rejected by Open
+#endif // !NFI_ZSTD
+}
+
+Compressor::~Compressor()
+{
+	if(Worker_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex_);
+			Stop_ = true;
+		}
+
+		Cond_.notify_all();
+		Worker_.join();
+	}
+
+	StreamFree();
+}
+
+void Compressor::StreamFree()
+{
+	if(nullptr == Stream_)
+	{
+		return;
+	}
+
+	switch(Type_)
+	{
+	case Compression::COMPRESSION_GZIP:
+		deflateEnd((z_stream *) Stream_);
+		delete (z_stream *) Stream_;
+		break;
+
+#if NFI_ZSTD
+	case Compression::COMPRESSION_ZSTD:
+		ZSTD_freeCStream((ZSTD_CStream *) Stream_);
+		break;
+#endif // NFI_ZSTD
+
+	default:
+		break;
+	}
+
+	Stream_ = nullptr;
+}
+
+int Compressor::Open(int fd, Compression::type_t type, const char * name)
+{
+	Fd_ = fd;
+	Type_ = type;
+	Name_ = name;
+
+	switch(Type_)
+	{
+	case Compression::COMPRESSION_NONE:
+		break;
+
+	case Compression::COMPRESSION_GZIP:
+	{
+		z_stream * stream = new z_stream;
+		memset(stream, 0, sizeof(*stream));
+		if(Z_OK != deflateInit2(stream, GzipLevel_, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY)) // gzip header
+		{
+			nfiError("deflateInit2 failed for %s\n", Name_);
+			delete stream;
+			return -1;
+		}
+
+		Stream_ = stream;
+	}
+		break;
+
+#if NFI_ZSTD
+	case Compression::COMPRESSION_ZSTD:
+	{
+		ZSTD_CStream * stream = ZSTD_createCStream();
+		if((nullptr == stream) || ZSTD_isError(ZSTD_initCStream(stream, ZstdLevel_)))
+		{
+			nfiError("ZSTD_initCStream failed for %s\n", Name_);
+			ZSTD_freeCStream(stream);
+			return -1;
+		}
+
+		Stream_ = stream;
+	}
+		break;
+#endif // NFI_ZSTD
+
+	default:
+		nfiError("Can't write %s compressed %s\n", Compression::Name(Type_), Name_);
+		return -1;
+	}
+
+	Buffer_.reserve(Compression::ChunkSize);
+	Pending_.reserve(Compression::ChunkSize);
+	Worker_ = std::thread([this, diagnostics = nfiDiagnostics]() { nfiDiagnostics = diagnostics; Work(); });
+
+	return 0;
+}
+
+int Compressor::Write(const char * data, size_t size)
+{
+	while(0 < size)
+	{
+		const size_t cnt = std::min(size, Compression::ChunkSize - Buffer_.size());
+		Buffer_.insert(Buffer_.end(), data, data + cnt);
+		data += cnt;
+		size -= cnt;
+
+		if((Compression::ChunkSize == Buffer_.size()) && ChunkHand(false))
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int Compressor::Close()
+{
+	const int ret = ChunkHand(true);
+
+	if(Worker_.joinable())
+	{
+		Worker_.join();
+	}
+
+	StreamFree();
+
+	return (ret || Failed_) ? -1 : 0;
+}
+
+// Hands the filled buffer to the worker, once it is done with the previous one
+int Compressor::ChunkHand(bool last)
+{
+	{
+		std::unique_lock<std::mutex> lock(Mutex_);
+		Cond_.wait(lock, [this]() { return !HasPending_ || Failed_; });
+
+		if(Failed_)
+		{
+			return -1;
+		}
+
+		Pending_.swap(Buffer_);
+		HasPending_ = true;
+		Closing_ = last;
+	}
+
+	Cond_.notify_all();
+	Buffer_.clear();
+
+	return 0;
+}
+
+void Compressor::Work()
+{
+	std::vector<char> out;
+	while(true)
+	{
+		std::unique_lock<std::mutex> lock(Mutex_);
+		Cond_.wait(lock, [this]() { return HasPending_ || Stop_; });
+		if(!HasPending_)
+		{
+			return; // stopped
+		}
+
+		const bool last = Closing_;
+		lock.unlock();
+
+		// Pending_ is left alone by the producer while HasPending_
+		const int ret = ChunkOut(Pending_, last, &out);
+
+		lock.lock();
+		HasPending_ = false;
+		Pending_.clear();
+		Failed_ = Failed_ || (0 != ret);
+		const bool done = last || Failed_;
+		lock.unlock();
+
+		Cond_.notify_all();
+
+		if(done)
+		{
+			return;
+		}
+	}
+}
+
+// Compresses and writes chunk, last ends the compressed stream
+int Compressor::ChunkOut(const std::vector<char> &chunk, bool last, std::vector<char> * out)
+{
+	out->resize(Compression::ChunkSize);
+
+	switch(Type_)
+	{
+	case Compression::COMPRESSION_NONE:
+		return OutWrite(chunk.data(), chunk.size());
+
+	case Compression::COMPRESSION_GZIP:
+	{
+		z_stream * stream = (z_stream *) Stream_;
+		stream->next_in = (unsigned char *) chunk.data();
+		stream->avail_in = chunk.size();
+
+		do {
+			stream->next_out = (unsigned char *) out->data();
+			stream->avail_out = out->size();
+
+			if(Z_STREAM_ERROR == deflate(stream, last ? Z_FINISH : Z_NO_FLUSH))
+			{
+				nfiError("deflate failed for %s\n", Name_);
+				return -1;
+			}
+
+			if(OutWrite(out->data(), out->size() - stream->avail_out))
+			{
+				return -1;
+			}
+		} while(0 == stream->avail_out);
+	}
+		return 0;
+
+#if NFI_ZSTD
+	case Compression::COMPRESSION_ZSTD:
+	{
+		ZSTD_inBuffer input = {chunk.data(), chunk.size(), 0};
+
+		bool finished = false;
+		while(!finished)
+		{
+			ZSTD_outBuffer output = {out->data(), out->size(), 0};
+			const size_t remaining = ZSTD_compressStream2((ZSTD_CStream *) Stream_, &output, &input,
+					last ? ZSTD_e_end : ZSTD_e_continue);
+			if(ZSTD_isError(remaining))
+			{
+				nfiError("ZSTD_compressStream2 failed for %s: %s\n", Name_, ZSTD_getErrorName(remaining));
+				return -1;
+			}
+
+			if(OutWrite(out->data(), output.pos))
+			{
+				return -1;
+			}
+
+			finished = last ? (0 == remaining) : (input.size == input.pos);
+		}
+	}
+		return 0;
+#endif // NFI_ZSTD
+
+	default:
+		return -1; // rejected by Open
+	}
+}
+
+int Compressor::OutWrite(const char * data, size_t size)
+{
+	while(0 < size)
+	{
+		const ssize_t written = write(Fd_, data, size);
+		if(0 > written)
+		{
+			if(EINTR == errno)
+			{
+				continue;
+			}
+
+			nfiError("write failed on %s\n", Name_);
+			return -1;
+		}
+
+		data += written;
+		size -= written;
+	}
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef COMPRESSION_H_
+#define COMPRESSION_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef NFI_ZSTD
+#define NFI_ZSTD 0 // zstd needs libzstd, e.g. make ZSTD=1
+#endif // NFI_ZSTD
+
+// Compression of netlist files, detected by magic number and kept when writing back
+class Compression {
+public:
+	typedef enum {
+		COMPRESSION_NONE,
+		COMPRESSION_GZIP,
+		COMPRESSION_ZSTD,
+		COMPRESSION_NROF
+	} type_t;
+
+	static constexpr size_t MagicSize = 4; // bytes needed by Detect
+
+	static type_t Detect(const unsigned char * head, size_t size);
+	static const char * Name(type_t type);
+
+	static constexpr size_t ChunkSize = 1 << 20; // of (de)compressed data handed between threads
+};
+
+// Sequential reader of a file, decompressing it on a thread of its own.
+// Uncompressed files are read as they are.
+class Decompressor {
+public:
+	Decompressor() = default;
+	~Decompressor();
+
+	Decompressor & operator=(const Decompressor&) = delete;
+	Decompressor(const Decompressor &decompressor) = delete;
+
+	// fd stays owned by the caller and must stay open until the end is read
+	int Open(int fd, const char * name);
+
+	// Returns bytes read into buffer, up to size, 0 at the end or negative on error
+	ssize_t Read(char * buffer, size_t size);
+
+	// Like Read, but only returns less than size at the end
+	ssize_t ReadFull(char * buffer, size_t size);
+
+	Compression::type_t Type() const { return Type_; }
+
+private:
+	int Fd_ = -1;
+	const char * Name_ = nullptr;
+	Compression::type_t Type_ = Compression::COMPRESSION_NONE;
+
+	unsigned char Head_[Compression::MagicSize]; // read for Detect, returned first
+	size_t HeadSize_ = 0;
+	size_t HeadPos_ = 0;
+
+	// Decompressed chunks, handed from the worker to Read
+	std::thread Worker_;
+	std::mutex Mutex_;
+	std::condition_variable Cond_;
+	std::vector<std::vector<char>> Chunks_; // queue, bounded by MaxChunks_
+	bool Done_ = false; // worker won't add chunks anymore
+	bool Failed_ = false;
+	bool Stop_ = false; // reader gave up, e.g. on destruction
+
+	std::vector<char> Current_; // chunk Read is working on
+	size_t CurrentPos_ = 0;
+
+	static constexpr size_t MaxChunks_ = 4;
+
+	ssize_t RawRead(unsigned char * buffer, size_t size);
+	void Work();
+	int ChunkPush(std::vector<char> &&chunk);
+	int GzipDecompress();
+	int ZstdDecompress();
+};
+
+// Buffered writer of a file, compressing it on a thread of its own.
+// With COMPRESSION_NONE the data is written as it is.
+class Compressor {
+public:
+	Compressor() = default;
+	~Compressor();
+
+	Compressor & operator=(const Compressor&) = delete;
+	Compressor(const Compressor &compressor) = delete;
+
+	// fd stays owned by the caller
+	int Open(int fd, Compression::type_t type, const char * name);
+
+	int Write(const char * data, size_t size);
+
+	// Ends the compressed stream and writes everything still buffered
+	int Close();
+
+private:
+	int Fd_ = -1;
+	const char * Name_ = nullptr;
+	Compression::type_t Type_ = Compression::COMPRESSION_NONE;
+
+	std::vector<char> Buffer_; // filled by Write
+
+	// At most one chunk is compressed while the next is filled
+	std::thread Worker_;
+	std::mutex Mutex_;
+	std::condition_variable Cond_;
+	std::vector<char> Pending_;
+	bool HasPending_ = false;
+	bool Closing_ = false; // no chunk after Pending_
+	bool Failed_ = false;
+	bool Stop_ = false; // destroyed before Close
+
+	void * Stream_ = nullptr; // z_stream or ZSTD_CStream
+
+	int ChunkHand(bool last);
+	void Work();
+	int ChunkOut(const std::vector<char> &chunk, bool last, std::vector<char> * out);
+	int OutWrite(const char * data, size_t size);
+	void StreamFree();
+
+	static constexpr int GzipLevel_ = 1; // deflate is slow, its fastest level keeps up best with writing
+	static constexpr int ZstdLevel_ = 3;
+};
+
+#endif /* COMPRESSION_H_ */
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#include "FiCache.h"
+#include "RtlFile.h"
+
+uint64_t FiCache::Hash(const void * data, size_t size, uint64_t hash)
+{
+	const unsigned char * bytes = (const unsigned char *) data;
+	for(size_t pos = 0; pos < size; pos++)
+	{
+		hash ^= bytes[pos];
+		hash *= 0x100000001b3ULL; // FNV prime
+	}
+
+	return hash;
+}
+
+const FiCache::entry_t * FiCache::Find(const std::string &moduleName, uint64_t hash) const
+{
+	const auto it = Entries_.find(moduleName);
+	if((Entries_.end() == it) || (hash != it->second.Hash))
+	{
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+const FiCache::entry_t * FiCache::Find(const std::string &moduleName) const
+{
+	const auto it = Entries_.find(moduleName);
+	if(Entries_.end() == it)
+	{
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+void FiCache::Store(const std::string &moduleName, entry_t &&entry)
+{
+	Entries_[moduleName] = std::move(entry);
+}
+
+// Returns position after the number or nullptr if there is none
+static const char * numberGet(uint64_t * number, const char * in, int base)
+{
+	char * end;
+	errno = 0;
+	*number = strtoull(in, &end, base);
+	if((end == in) || errno)
+	{
+		return nullptr;
+	}
+
+	return end;
+}
+
+// Returns rest of line after a single space, without newline, or nullptr
+static const char * restGet(const char * in)
+{
+	if(' ' != *in)
+	{
+		return nullptr;
+	}
+
+	return in + 1;
+}
+
+int FiCache::Load(const std::string &fileName)
+{
+	Entries_.clear();
+	Top_.clear();
+
+	FILE * filep = fopen(fileName.c_str(), "r");
+	if(nullptr == filep)
+	{
+		errno = 0;
+		return 0; // first run
+	}
+
+	char * line = nullptr;
+	size_t lineCapacity = 0;
+	ssize_t lineLen;
+	size_t lineNr = 0;
+	entry_t * entry = nullptr;
+	uint64_t sitesCnt = 0; // of entry
+	uint64_t instancesCnt = 0;
+	int ret = 0;
+
+	while(0 < (lineLen = getline(&line, &lineCapacity, filep)))
+	{
+		lineNr++;
+		if('\n' == line[lineLen - 1])
+		{
+			line[lineLen - 1] = '\0';
+		}
+
+		if(1 == lineNr)
+		{
+			if(strcmp(line, Magic_))
+			{
+				ret = -1;
+				break;
+			}
+			continue;
+		}
+
+		if(2 == lineNr)
+		{
+			if(strncmp(line, "top ", 4))
+			{
+				ret = -1;
+				break;
+			}
+
+			Top_ = line + 4;
+			continue;
+		}
+
+		uint64_t values[4];
+		const char * pos;
+		if(0 == strncmp(line, "module ", 7))
+		{
+			// A truncated file may end at a line, so the entry before must be complete
+			if((nullptr != entry) && ((entry->Sites.size() != sitesCnt) || (entry->Instances.size() != instancesCnt)))
+			{
+				ret = -1;
+				break;
+			}
+
+			pos = line + 7;
+			const char * nameEnd = strchr(pos, ' ');
+			if((nullptr == nameEnd) || (nullptr == (pos = numberGet(&values[0], nameEnd + 1, 16))) ||
+					(nullptr == (pos = numberGet(&sitesCnt, pos, 10))) || (nullptr == numberGet(&instancesCnt, pos, 10)))
+			{
+				ret = -1;
+				break;
+			}
+
+			entry = &Entries_[std::string(line + 7, nameEnd - (line + 7))];
+			entry->Hash = values[0];
+		}
+		else if((nullptr != entry) && (0 == strncmp(line, "site ", 5)))
+		{
+			pos = line + 4;
+			for(size_t value = 0; (value < 4) && (nullptr != pos); value++)
+			{
+				pos = numberGet(&values[value], pos, 10);
+			}
+
+			if((nullptr == pos) || (nullptr == (pos = restGet(pos))))
+			{
+				ret = -1;
+				break;
+			}
+
+			entry->Sites.push_back({values[0], values[1], values[2], values[3], pos});
+		}
+		else if((nullptr != entry) && (0 == strncmp(line, "inst ", 5)))
+		{
+			pos = line + 4;
+			for(size_t value = 0; (value < 2) && (nullptr != pos); value++)
+			{
+				pos = numberGet(&values[value], pos, 10);
+			}
+
+			if((nullptr == pos) || (nullptr == (pos = restGet(pos))))
+			{
+				ret = -1;
+				break;
+			}
+
+			entry->Instances.push_back({values[0], values[1], pos});
+		}
+		else
+		{
+			ret = -1;
+			break;
+		}
+	}
+
+	free(line);
+	fclose(filep);
+
+	if((0 == ret) && (nullptr != entry) && ((entry->Sites.size() != sitesCnt) || (entry->Instances.size() != instancesCnt)))
+	{
+		ret = -1;
+	}
+
+	if(ret)
+	{
+		// Stale or foreign file, everything is instrumented from scratch
+		nfiWarning("Ignoring cache %s, unexpected line %lu\n", fileName.c_str(), lineNr);
+		Entries_.clear();
+		Top_.clear();
+	}
+
+	errno = 0;
+
+	return 0;
+}
+
+int FiCache::Save(const std::string &fileName) const
+{
+	// Written like the netlists, so a failed run never leaves a truncated cache and concurrent runs don't collide
+	std::string tmpName;
+	const int fd = RtlFile::OutputOpen(&tmpName, fileName);
+	if(0 > fd)
+	{
+		nfiError("OutputOpen failed for %s\n", fileName.c_str());
+		return -1;
+	}
+
+	// Of a duplicate, as OutputCommit closes fd
+	const int fileFd = dup(fd);
+	FILE * const filep = (0 > fileFd) ? nullptr : fdopen(fileFd, "w");
+	if(nullptr == filep)
+	{
+		nfiError("fdopen failed for %s\n", fileName.c_str());
+		if(0 <= fileFd)
+		{
+			close(fileFd);
+		}
+
+		RtlFile::OutputAbort(fd, tmpName);
+		return -1;
+	}
+
+	bool failed = (0 > fprintf(filep, "%s\ntop %s\n", Magic_, Top_.c_str()));
+	for(const auto &entry: Entries_)
+	{
+		failed |= (0 > fprintf(filep, "module %s %016" PRIx64 " %lu %lu\n", entry.first.c_str(), entry.second.Hash,
+				entry.second.Sites.size(), entry.second.Instances.size()));
+
+		for(const auto &site: entry.second.Sites)
+		{
+			failed |= (0 > fprintf(filep, "site %lu %lu %lu %lu %s\n",
+					site.Start, site.End, site.Width, site.UUID, site.Name.c_str()));
+		}
+
+		for(const auto &instance: entry.second.Instances)
+		{
+			failed |= (0 > fprintf(filep, "inst %lu %lu %s\n", instance.InputsEnd, instance.UUID, instance.Type.c_str()));
+		}
+	}
+
+	if(fclose(filep) || failed)
+	{
+		nfiError("Writing to %s failed\n", fileName.c_str());
+		RtlFile::OutputAbort(fd, tmpName);
+		return -1;
+	}
+
+	return RtlFile::OutputCommit(fd, tmpName, fileName);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef FICACHE_H_
+#define FICACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Instrumentation results of earlier runs, keyed by module name and a hash of the module.
+// Modules whose hash didn't change are re-rendered from here instead of being parsed again.
+class FiCache {
+public:
+	typedef struct {
+		size_t Start; // after '=' of the assignment, relative to module start
+		size_t End; // at ';' of the assignment, relative to module start
+		size_t Width;
+		size_t UUID;
+		std::string Name;
+	} site_t;
+
+	typedef struct {
+		size_t InputsEnd; // where fiEnable is connected, relative to module start
+		size_t UUID; // 0 if the instantiated module was not part of the netlist
+		std::string Type; // name of instantiated module
+	} instance_t;
+
+	typedef struct {
+		uint64_t Hash;
+		std::vector<site_t> Sites; // in text order
+		std::vector<instance_t> Instances; // in text order
+	} entry_t;
+
+	static constexpr uint64_t HashInit = 0xcbf29ce484222325ULL; // FNV-1a offset basis
+
+	// FNV-1a, continues from hash
+	static uint64_t Hash(const void * data, size_t size, uint64_t hash = HashInit);
+
+	int Load(const std::string &fileName); // a missing file is an empty cache
+	int Save(const std::string &fileName) const;
+
+	const entry_t * Find(const std::string &moduleName, uint64_t hash) const; // nullptr if not cached
+	const entry_t * Find(const std::string &moduleName) const; // whatever the hash, nullptr if not cached
+	void Store(const std::string &moduleName, entry_t &&entry);
+	void Clear() { Entries_.clear(); }
+
+	// Top module of the design the cache was written for, entries of other designs are of no use
+	const std::string &Top() const { return Top_; }
+	void TopSet(const std::string &top) { Top_ = top; }
+
+private:
+	static constexpr char Magic_[] = "nfiCache 2";
+
+	std::string Top_;
+
+	std::map<std::string, entry_t> Entries_; // ordered, so saved files don't depend on hashing
+};
+
+#endif /* FICACHE_H_ */
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "FiCache.h"
+#include "RtlDesign.h"
+#include "RtlStream.h"
+#include "YosysJson.h"
+
+#include "Instrumenter.h"
+
+Instrumenter::Instrumenter(const options_t &options, FILE * diagnostics) :
+		Options_(options),
+		Diagnostics_({diagnostics, 0})
+{
+}
+
+bool Instrumenter::StdoutUsed(const options_t &options, bool library)
+{
+	// Neither is written when analyzing
+	if(options.Analyze)
+	{
+		return false;
+	}
+
+	if(library && (0 == strcmp(options.Library.c_str(), RtlFile::StdioName)))
+	{
+		return true;
+	}
+
+	if(!options.Output.empty())
+	{
+		return (0 == strcmp(options.Output.c_str(), RtlFile::StdioName));
+	}
+
+	return options.Files.end() != std::find(options.Files.begin(), options.Files.end(), std::string(RtlFile::StdioName));
+}
+
+int Instrumenter::OptionsCheck(const options_t &options)
+{
+	if(options.Files.empty() || options.TopModule.empty())
+	{
+		nfiError("No fileName / topModule supplied\n");
+		return -1;
+	}
+
+	if(0 == options.Jobs)
+	{
+		nfiError("At least one job is needed\n");
+		return -1;
+	}
+
+	if((0 != options.StreamWindow) && !options.CacheFile.empty())
+	{
+		nfiError("--cache can't be combined with --stream\n");
+		return -1;
+	}
+
+	if((0 != options.StreamWindow) && options.Analyze)
+	{
+		nfiError("--analyze can't be combined with --stream\n");
+		return -1;
+	}
+
+	if((0 == strcmp(options.Library.c_str(), RtlFile::StdioName)) && StdoutUsed(options, false))
+	{
+		nfiError("The netlist and the library can't both be written to stdout\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int Instrumenter::Run()
+{
+	// Diagnostics of this thread go to this instance for the run, worker threads take them over
+	nfiDiagnostics_t * const previous = nfiDiagnostics;
+	nfiDiagnostics = &Diagnostics_;
+
+	const size_t errorCnt = ErrorCnt();
+
+	Profiler profiler;
+	Profiler * const profilerUsed = Options_.ProfileFile.empty() ? nullptr : &profiler;
+
+	// Reports must not mix with output on stdout, e.g. the analysis
+	FILE * report = Options_.Report;
+	if(nullptr == report)
+	{
+		report = ((Options_.Analyze && (nullptr == Options_.Analysis)) || StdoutUsed(Options_, true)) ? stderr : stdout;
+	}
+
+	int ret = Instrument(report, profilerUsed);
+
+	// E.g. of single files, which don't stop the others
+	if(errorCnt != ErrorCnt())
+	{
+		ret = -1;
+	}
+
+	nfiDiagnostics = previous;
+
+	return ret;
+}
+
+int Instrumenter::Instrument(FILE * report, Profiler * profiler)
+{
+	if(OptionsCheck(Options_))
+	{
+		nfiError("OptionsCheck failed\n");
+		return -1;
+	}
+
+	if((0 != Options_.StreamWindow) ? StreamRun(report, profiler) : DesignRun(report, profiler))
+	{
+		return -1;
+	}
+
+	if(nullptr != profiler)
+	{
+		if(profiler->TraceWrite(Options_.ProfileFile) || profiler->SummaryPrint(report))
+		{
+			nfiError("Writing profile failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Loads all files, instruments them and writes them back
+int Instrumenter::DesignRun(FILE * report, Profiler * profiler)
+{
+	// Get files
+	RtlDesign rtlDesign;
+	rtlDesign.Timer().ProfilerSet(profiler);
+	rtlDesign.OutputSet(Options_.Output, Options_.Library);
+	rtlDesign.UnreachableDropSet(Options_.UnreachableDrop);
+	rtlDesign.AnalyzeSet(Options_.Analyze);
+
+	if(rtlDesign.Get(Options_.Files, Options_.TopModule, Options_.Jobs))
+	{
+		nfiError("fileGet failed\n");
+		return -1;
+	}
+
+	YosysJson json;
+	if(!Options_.YosysJson.empty())
+	{
+		rtlDesign.Timer().Start("YosysJson");
+		if(json.Load(Options_.YosysJson))
+		{
+			nfiError("Loading %s failed\n", Options_.YosysJson.c_str());
+			return -1;
+		}
+
+		rtlDesign.YosysJsonSet(&json);
+	}
+
+	FiCache cache;
+	if(!Options_.CacheFile.empty())
+	{
+		rtlDesign.Timer().Start("CacheLoad");
+		if(cache.Load(Options_.CacheFile))
+		{
+			nfiError("Loading cache failed\n");
+			return -1;
+		}
+	}
+
+	if(rtlDesign.FiSignalsCreate(RtlFile::FI_MODE_FLIP, Options_.Jobs,
+			Options_.CacheFile.empty() ? nullptr : &cache))
+	{
+		nfiError("Failed to insert FiSignals\n");
+		return -1;
+	}
+
+	if(Options_.Analyze)
+	{
+		if(rtlDesign.AnalysisPrint((nullptr != Options_.Analysis) ? Options_.Analysis : stdout))
+		{
+			nfiError("AnalysisPrint failed\n");
+			return -1;
+		}
+	}
+	else if(rtlDesign.WriteBack(Options_.Jobs))
+	{
+		nfiError("WriteBack failed\n");
+		return -1;
+	}
+
+	// Only a written netlist matches the cache
+	if(!Options_.CacheFile.empty() && !Options_.Analyze)
+	{
+		rtlDesign.Timer().Start("CacheSave");
+		if(cache.Save(Options_.CacheFile))
+		{
+			nfiError("Saving cache failed\n");
+			return -1;
+		}
+
+		rtlDesign.Timer().Stop();
+	}
+
+	if(Options_.Timing && (rtlDesign.Timer().Report(report, rtlDesign.Size()) || rtlDesign.HierarchyPrint(report)))
+	{
+		nfiError("Timing report failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Instruments the files window by window, never loading a whole file
+int Instrumenter::StreamRun(FILE * report, Profiler * profiler)
+{
+	RtlStream rtlStream;
+	rtlStream.Timer().ProfilerSet(profiler);
+	rtlStream.OutputSet(Options_.Output, Options_.Library);
+	rtlStream.UnreachableDropSet(Options_.UnreachableDrop);
+
+	// Loaded up front, the phases of the stream start with its scan
+	YosysJson json;
+	if(!Options_.YosysJson.empty())
+	{
+		if(json.Load(Options_.YosysJson))
+		{
+			nfiError("Loading %s failed\n", Options_.YosysJson.c_str());
+			return -1;
+		}
+
+		rtlStream.YosysJsonSet(&json);
+	}
+
+	if(rtlStream.Run(Options_.Files, Options_.TopModule, RtlFile::FI_MODE_FLIP,
+			Options_.StreamWindow, Options_.Jobs))
+	{
+		nfiError("Streaming instrumentation failed\n");
+		return -1;
+	}
+
+	if(Options_.Timing && (rtlStream.Timer().Report(report, rtlStream.Size()) || rtlStream.HierarchyPrint(report)))
+	{
+		nfiError("Timing report failed\n");
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef INSTRUMENTER_H_
+#define INSTRUMENTER_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "Profiler.h"
+
+// Instruments one netlist per Run, e.g. variants or partitions one after the other in a long-lived process.
+// Instances share no state, so they may run concurrently in different threads.
+// Errors and warnings of a run, also of its worker threads, go to the diagnostics of its instance.
+class Instrumenter {
+public:
+	typedef struct {
+		std::vector<std::string> Files; // files or directories, "-" for stdin
+		std::string TopModule;
+		size_t Jobs = 1;
+		std::string CacheFile; // empty if not used
+		bool Timing = false; // print time of each phase
+		std::string ProfileFile; // empty if not used
+		size_t StreamWindow = 0; // bytes, 0 if whole files are loaded
+		std::string Output; // file, directory or "-" for stdout, empty if written back
+		std::string Library; // "-" for stdout, empty for "<topModule>FiSignals.cpp"
+		bool UnreachableDrop = false; // remove modules not instantiated below the top module
+		bool Analyze = false; // only report the fault space, write nothing
+		std::string YosysJson; // write_json of the netlist for exact net widths, empty if not used
+		FILE * Report = nullptr; // of timing and profile, nullptr for stdout or stderr if stdout is taken
+		FILE * Analysis = nullptr; // JSON report of Analyze, nullptr for stdout
+	} options_t;
+
+	// Diagnostics are written to diagnostics
+	explicit Instrumenter(const options_t &options, FILE * diagnostics = stderr);
+
+	Instrumenter & operator=(const Instrumenter&) = delete;
+	Instrumenter(const Instrumenter &instrumenter) = delete;
+
+	// Fails on options that can't be combined
+	static int OptionsCheck(const options_t &options);
+
+	// Instruments the netlist, fails if any error was reported meanwhile
+	int Run();
+
+	const options_t &Options() const { return Options_; }
+	void OptionsSet(const options_t &options) { Options_ = options; }
+
+	size_t ErrorCnt() const { return __atomic_load_n(&Diagnostics_.ErrorCnt, __ATOMIC_RELAXED); } // of all runs
+
+	// The netlist goes to stdout with Output "-" or if read from stdin, the library only with Library "-"
+	static bool StdoutUsed(const options_t &options, bool library);
+
+private:
+	options_t Options_;
+	nfiDiagnostics_t Diagnostics_;
+
+	int Instrument(FILE * report, Profiler * profiler);
+	int DesignRun(FILE * report, Profiler * profiler);
+	int StreamRun(FILE * report, Profiler * profiler);
+};
+
+#endif /* INSTRUMENTER_H_ */
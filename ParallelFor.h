@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef PARALLELFOR_H_
+#define PARALLELFOR_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+// Calls func(index) for all index in [0, cnt) using up to jobs threads, incl. the calling one.
+// Indices are handed out dynamically, so func must not depend on the order of calls.
+// Errors of all threads go to the diagnostics of the calling one.
+template<typename func_t>
+void parallelFor(size_t cnt, size_t jobs, const func_t &func)
+{
+	std::atomic<size_t> nextIndex(0);
+	nfiDiagnostics_t * const diagnostics = nfiDiagnostics;
+
+	auto worker = [&]() {
+		nfiDiagnostics = diagnostics;
+		for(size_t index = nextIndex++; index < cnt; index = nextIndex++)
+		{
+			func(index);
+		}
+	};
+
+	const size_t threadCnt = std::min(jobs, cnt);
+	std::vector<std::thread> threads;
+	for(size_t thread = 1; thread < threadCnt; thread++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for(auto &thread: threads)
+	{
+		thread.join();
+	}
+}
+
+#endif /* PARALLELFOR_H_ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <sys/resource.h>
+
+#include "common.h"
+
+#include "PhaseTimer.h"
+
+void PhaseTimer::Start(const char * name)
+{
+	Stop();
+
+	Phases_.push_back({name, 0.0});
+	Running_ = true;
+	Started_ = steadyClock_t::now();
+
+	if(nullptr != Profiler_)
+	{
+		ProfilerStart_ = Profiler_->Now();
+	}
+}
+
+void PhaseTimer::Stop()
+{
+	if(!Running_)
+	{
+		return;
+	}
+
+	Phases_.back().Seconds = std::chrono::duration<double>(steadyClock_t::now() - Started_).count();
+	Running_ = false;
+
+	if(nullptr != Profiler_)
+	{
+		Profiler_->Record(Profiler::CategoryPhase, Phases_.back().Name, ProfilerStart_, Profiler_->Now());
+	}
+}
+
+int PhaseTimer::Report(FILE * filep, size_t bytes) const
+{
+	const double megaBytes = bytes / (1024.0 * 1024.0);
+
+	double total = 0.0;
+	fprintf(filep, "%-16s %10s %10s\n", "Phase", "Seconds", "MB/s");
+	for(const auto &phase: Phases_)
+	{
+		total += phase.Seconds;
+		fprintf(filep, "%-16s %10.4f %10.1f\n", phase.Name.c_str(), phase.Seconds,
+				(0.0 < phase.Seconds) ? megaBytes / phase.Seconds : 0.0);
+	}
+
+	fprintf(filep, "%-16s %10.4f %10.1f\n", "Total", total, (0.0 < total) ? megaBytes / total : 0.0);
+
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage))
+	{
+		nfiError("getrusage failed\n");
+		return -1;
+	}
+
+	// ru_maxrss is in KiB on Linux
+	fprintf(filep, "Input %.1f MB, peak RSS %.1f MB\n", megaBytes, usage.ru_maxrss / 1024.0);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef PHASETIMER_H_
+#define PHASETIMER_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Profiler.h"
+
+// Wall clock time of consecutive phases, e.g. of instrumenting a design
+class PhaseTimer {
+public:
+	typedef struct {
+		std::string Name;
+		double Seconds;
+	} phase_t;
+
+	void Start(const char * name); // stops the running phase, if any
+	void Stop();
+
+	// Phases are recorded in profiler too, nullptr to stop
+	void ProfilerSet(Profiler * profiler) { Profiler_ = profiler; }
+	Profiler * ProfilerGet() const { return Profiler_; }
+
+	const std::vector<phase_t> &Phases() const { return Phases_; }
+
+	// Prints seconds and throughput of each phase for bytes of input, plus peak RSS
+	int Report(FILE * filep, size_t bytes) const;
+
+private:
+	typedef std::chrono::steady_clock steadyClock_t;
+
+	std::vector<phase_t> Phases_;
+	steadyClock_t::time_point Started_;
+	bool Running_ = false;
+
+	Profiler * Profiler_ = nullptr;
+	uint64_t ProfilerStart_ = 0;
+};
+
+#endif /* PHASETIMER_H_ */
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+#include "common.h"
+
+#include "Profiler.h"
+
+Profiler::Profiler() : Epoch_(steadyClock_t::now())
+{
+}
+
+uint64_t Profiler::Now() const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(steadyClock_t::now() - Epoch_).count();
+}
+
+// Small numbers instead of std::thread::id, in order of first use
+uint32_t Profiler::ThreadId()
+{
+	static std::atomic<uint32_t> nextId(0);
+	static thread_local const uint32_t id = nextId++;
+
+	return id;
+}
+
+Profiler::Scope::Scope(Profiler * profiler, const char * category, std::string_view name) :
+		Profiler_(profiler), Category_(category), Name_(name), Start_(0)
+{
+	if(nullptr == Profiler_)
+	{
+		return;
+	}
+
+	memcpy(Counters_, Profiler::Counters_, sizeof(Counters_));
+	Start_ = Profiler_->Now();
+}
+
+Profiler::Scope::~Scope()
+{
+	if(nullptr == Profiler_)
+	{
+		return;
+	}
+
+	event_t event;
+	event.Name = Name_;
+	event.Category = Category_;
+	event.Thread = ThreadId();
+	event.Start = Start_;
+	event.Duration = Profiler_->Now() - Start_;
+	for(size_t counter = 0; counter < COUNTER_NROF; counter++)
+	{
+		event.Counters[counter] = Profiler::Counters_[counter] - Counters_[counter];
+	}
+
+	Profiler_->EventAdd(std::move(event));
+}
+
+void Profiler::Record(const char * category, std::string_view name, uint64_t startUs, uint64_t endUs)
+{
+	event_t event;
+	event.Name = name;
+	event.Category = category;
+	event.Thread = ThreadId();
+	event.Start = startUs;
+	event.Duration = endUs - startUs;
+	memset(event.Counters, 0, sizeof(event.Counters));
+
+	EventAdd(std::move(event));
+}
+
+void Profiler::EventAdd(event_t &&event)
+{
+	std::lock_guard<std::mutex> lock(Mutex_);
+	Events_.push_back(std::move(event));
+}
+
+// Phases get the sums of all other scopes that started during them
+void Profiler::PhaseCountersSum(std::vector<event_t> * events) const
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex_);
+		*events = Events_;
+	}
+
+	std::stable_sort(events->begin(), events->end(),
+			[](const event_t &a, const event_t &b) { return a.Start < b.Start; });
+
+	// Scopes nested in another one of the same thread, e.g. modules within a file, are already counted by it
+	std::vector<bool> nested(events->size(), false);
+	std::vector<size_t> order(events->size());
+	for(size_t event = 0; event < order.size(); event++)
+	{
+		order[event] = event;
+	}
+
+	std::sort(order.begin(), order.end(), [events](size_t a, size_t b) {
+		const event_t &eventA = (*events)[a];
+		const event_t &eventB = (*events)[b];
+		if(eventA.Thread != eventB.Thread)
+		{
+			return eventA.Thread < eventB.Thread;
+		}
+
+		if(eventA.Start != eventB.Start)
+		{
+			return eventA.Start < eventB.Start;
+		}
+
+		return eventA.Duration > eventB.Duration;
+	});
+
+	const event_t * outer = nullptr;
+	for(const size_t event: order)
+	{
+		const event_t &cur = (*events)[event];
+		if(0 == strcmp(CategoryPhase, cur.Category))
+		{
+			continue;
+		}
+
+		if((nullptr != outer) && (outer->Thread == cur.Thread) && (cur.Start + cur.Duration <= outer->Start + outer->Duration))
+		{
+			nested[event] = true;
+			continue;
+		}
+
+		outer = &cur;
+	}
+
+	for(auto &phase: *events)
+	{
+		if(0 != strcmp(CategoryPhase, phase.Category))
+		{
+			continue;
+		}
+
+		for(size_t event = 0; event < events->size(); event++)
+		{
+			const event_t &cur = (*events)[event];
+			if(nested[event] || (0 == strcmp(CategoryPhase, cur.Category)) || (cur.Start < phase.Start) ||
+					(phase.Start + phase.Duration < cur.Start))
+			{
+				continue;
+			}
+
+			for(size_t counter = 0; counter < COUNTER_NROF; counter++)
+			{
+				phase.Counters[counter] += cur.Counters[counter];
+			}
+		}
+	}
+}
+
+void Profiler::JsonEscape(std::string * out, std::string_view in)
+{
+	out->clear();
+	for(const auto &c: in)
+	{
+		if(('"' == c) || ('\\' == c))
+		{
+			out->push_back('\\');
+			out->push_back(c);
+		}
+		else if((unsigned char) c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out->append(escaped);
+		}
+		else
+		{
+			out->push_back(c);
+		}
+	}
+}
+
+int Profiler::TraceWrite(const std::string &fileName) const
+{
+	std::vector<event_t> events;
+	PhaseCountersSum(&events);
+
+	FILE * filep = fopen(fileName.c_str(), "w");
+	if(nullptr == filep)
+	{
+		nfiError("Failed to write-open %s\n", fileName.c_str());
+		return -1;
+	}
+
+	int ret = fprintf(filep, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+	std::string name;
+	for(size_t nr = 0; (0 <= ret) && (nr < events.size()); nr++)
+	{
+		const event_t &event = events[nr];
+		JsonEscape(&name, event.Name);
+
+		ret = fprintf(filep, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+				"\"ts\": %lu, \"dur\": %lu, \"args\": {",
+				name.c_str(), event.Category, event.Thread, event.Start, event.Duration);
+
+		for(size_t counter = 0; (0 <= ret) && (counter < COUNTER_NROF); counter++)
+		{
+			ret = fprintf(filep, "%s\"%s\": %lu", (0 == counter) ? "" : ", ", CounterNames_[counter], event.Counters[counter]);
+		}
+
+		if(0 <= ret)
+		{
+			ret = fprintf(filep, "}}%s\n", (nr + 1 < events.size()) ? "," : "");
+		}
+	}
+
+	if(0 <= ret)
+	{
+		ret = fprintf(filep, "]}\n");
+	}
+
+	if(0 > ret)
+	{
+		nfiError("Writing to %s failed\n", fileName.c_str());
+		fclose(filep);
+		return -1;
+	}
+
+	if(fclose(filep))
+	{
+		nfiError("Closing %s failed\n", fileName.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+int Profiler::SummaryPrint(FILE * filep) const
+{
+	static const size_t slowestCnt = 10;
+
+	std::vector<event_t> events;
+	PhaseCountersSum(&events);
+
+	fprintf(filep, "%-20s %10s", "Phase", "ms");
+	for(const auto &counterName: CounterNames_)
+	{
+		fprintf(filep, " %18s", counterName);
+	}
+	fprintf(filep, "\n");
+
+	// Modules over all phases, e.g. lexing and instrumenting
+	std::map<std::string, event_t> modules;
+	for(const auto &event: events)
+	{
+		if(0 == strcmp(CategoryPhase, event.Category))
+		{
+			fprintf(filep, "%-20s %10.1f", event.Name.c_str(), event.Duration / 1000.0);
+			for(const auto &count: event.Counters)
+			{
+				fprintf(filep, " %18lu", count);
+			}
+			fprintf(filep, "\n");
+		}
+		else if(0 == strcmp(CategoryModule, event.Category))
+		{
+			auto it = modules.find(event.Name);
+			if(modules.end() == it)
+			{
+				modules[event.Name] = event;
+				continue;
+			}
+
+			it->second.Duration += event.Duration;
+			for(size_t counter = 0; counter < COUNTER_NROF; counter++)
+			{
+				it->second.Counters[counter] += event.Counters[counter];
+			}
+		}
+	}
+
+	std::vector<const event_t *> slowest;
+	for(const auto &module: modules)
+	{
+		slowest.push_back(&module.second);
+	}
+
+	std::sort(slowest.begin(), slowest.end(),
+			[](const event_t * a, const event_t * b) { return a->Duration > b->Duration; });
+	slowest.resize(std::min(slowest.size(), slowestCnt));
+
+	fprintf(filep, "\nSlowest of %lu modules:\n", modules.size());
+	for(const auto &module: slowest)
+	{
+		fprintf(filep, "%10.1f ms %10lu needles  %.80s\n", module->Duration / 1000.0,
+				module->Counters[COUNTER_NEEDLES], module->Name.c_str());
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Scoped timings and counters of phases, files and modules, written as Chrome trace JSON.
+// Counters are always counted per thread, scopes are only recorded with a profiler.
+class Profiler {
+public:
+	typedef enum {
+		COUNTER_NEEDLES, // assignments found by the lexer
+		COUNTER_COMMENT_CHECKS, // lookups in the comment index
+		COUNTER_DECLARATION_LOOKUPS,
+		COUNTER_DIFF_BYTES, // replacement bytes applied by DiffApply
+		COUNTER_WRITE_BYTES, // bytes written back
+		COUNTER_NROF
+	} counter_t;
+
+	static void Count(counter_t counter, uint64_t cnt = 1) { Counters_[counter] += cnt; }
+
+	Profiler();
+
+	// Times its lifetime and the counts of the calling thread meanwhile, no-op if profiler is nullptr
+	class Scope {
+	public:
+		Scope(Profiler * profiler, const char * category, std::string_view name);
+		~Scope();
+
+		Scope & operator=(const Scope&) = delete;
+		Scope(const Scope &scope) = delete;
+
+	private:
+		Profiler * Profiler_;
+		const char * Category_;
+		std::string_view Name_;
+		uint64_t Start_;
+		uint64_t Counters_[COUNTER_NROF];
+	};
+
+	// Phases run one after the other on the calling thread, their counters are the sums of the scopes inside them
+	void Record(const char * category, std::string_view name, uint64_t startUs, uint64_t endUs);
+
+	uint64_t Now() const; // microseconds since construction
+
+	int TraceWrite(const std::string &fileName) const;
+
+	// Sets out to in as the inside of a JSON string
+	static void JsonEscape(std::string * out, std::string_view in);
+	int SummaryPrint(FILE * filep) const;
+
+	static constexpr char CategoryPhase[] = "phase";
+	static constexpr char CategoryFile[] = "file";
+	static constexpr char CategoryModule[] = "module";
+
+private:
+	typedef std::chrono::steady_clock steadyClock_t;
+
+	typedef struct {
+		std::string Name;
+		const char * Category;
+		uint32_t Thread;
+		uint64_t Start; // microseconds since construction
+		uint64_t Duration;
+		uint64_t Counters[COUNTER_NROF];
+	} event_t;
+
+	static constexpr const char * CounterNames_[COUNTER_NROF] = {
+			"needles", "commentChecks", "declarationLookups", "diffBytes", "writeBytes"};
+
+	static inline thread_local uint64_t Counters_[COUNTER_NROF] = {}; // of the calling thread, only increase
+
+	static uint32_t ThreadId();
+
+	const steadyClock_t::time_point Epoch_;
+
+	mutable std::mutex Mutex_; // guards Events_
+	std::vector<event_t> Events_;
+
+	void EventAdd(event_t &&event);
+	void PhaseCountersSum(std::vector<event_t> * events) const;
+};
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,807 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "common.h"
+
+#include "ParallelFor.h"
+#include "RtlDesign.h"
+
+static bool hasSuffix(const std::string &str, const char * suffix)
+{
+	const size_t len = strlen(suffix);
+
+	return (len <= str.size()) && (0 == str.compare(str.size() - len, len, suffix));
+}
+
+int RtlDesign::PathsExpand(std::vector<std::string> * fileNames, const std::vector<std::string> &paths)
+{
+	for(const auto &path: paths)
+	{
+		if(0 == strcmp(path.c_str(), RtlFile::StdioName))
+		{
+			fileNames->push_back(path);
+			continue;
+		}
+
+		struct stat pathStat;
+		if(stat(path.c_str(), &pathStat))
+		{
+			nfiError("stat failed on %s\n", path.c_str());
+			return -1;
+		}
+
+		if(!S_ISDIR(pathStat.st_mode))
+		{
+			fileNames->push_back(path);
+			continue;
+		}
+
+		DIR * dir = opendir(path.c_str());
+		if(nullptr == dir)
+		{
+			nfiError("opendir failed on %s\n", path.c_str());
+			return -1;
+		}
+
+		// Sorted, so UUIDs don't depend on the directory order
+		std::vector<std::string> dirFiles;
+		const struct dirent * dirEntry;
+		while(nullptr != (dirEntry = readdir(dir)))
+		{
+			const std::string fileName = path + "/" + dirEntry->d_name;
+
+			// Compressed files are recognized by their content, the suffix only selects them
+			const bool netlist = hasSuffix(fileName, ".v") || hasSuffix(fileName, ".v.gz") || hasSuffix(fileName, ".v.zst");
+
+			struct stat fileStat;
+			if(netlist && !stat(fileName.c_str(), &fileStat) && S_ISREG(fileStat.st_mode))
+			{
+				dirFiles.push_back(fileName);
+			}
+		}
+
+		closedir(dir);
+		errno = 0;
+
+		if(dirFiles.empty())
+		{
+			nfiError("No *.v, *.v.gz or *.v.zst file in %s\n", path.c_str());
+			return -1;
+		}
+
+		std::sort(dirFiles.begin(), dirFiles.end());
+		fileNames->insert(fileNames->end(), dirFiles.begin(), dirFiles.end());
+	}
+
+	return 0;
+}
+
+int RtlDesign::OutputsCheck(const std::vector<std::string> &fileNames, const std::string &output)
+{
+	std::vector<std::string> outputs;
+	for(const auto &fileName: fileNames)
+	{
+		outputs.push_back(RtlFile::OutputName(output, fileName));
+	}
+
+	std::sort(outputs.begin(), outputs.end());
+	for(size_t file = 1; file < outputs.size(); file++)
+	{
+		if((outputs[file - 1] == outputs[file]) && (0 != strcmp(outputs[file].c_str(), RtlFile::StdioName)))
+		{
+			nfiError("Several files would be written to %s\n", outputs[file].c_str());
+			return -1;
+		}
+	}
+
+	// stdin is read once, its output must not be stdin itself either
+	if(1 < std::count(fileNames.begin(), fileNames.end(), std::string(RtlFile::StdioName)))
+	{
+		nfiError("stdin given more than once\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+void RtlDesign::OutputSet(const std::string &output, const std::string &library)
+{
+	Output_ = output;
+	Library_ = library;
+}
+
+int RtlDesign::Get(const std::vector<std::string> &paths, const std::string &topModule, size_t jobs)
+{
+	if(!Files_.empty())
+	{
+		nfiError("RtlDesign already contains files\n");
+		return -1;
+	}
+
+	std::vector<std::string> fileNames;
+	if(PathsExpand(&fileNames, paths))
+	{
+		nfiError("PathsExpand failed\n");
+		return -1;
+	}
+
+	if(OutputsCheck(fileNames, Output_))
+	{
+		nfiError("OutputsCheck failed\n");
+		return -1;
+	}
+
+	TopModule_ = topModule;
+
+	for(size_t file = 0; file < fileNames.size(); file++)
+	{
+		Files_.emplace_back(new RtlFile());
+		Files_.back()->OutputSet(Output_.empty() ? "" : RtlFile::OutputName(Output_, fileNames[file]));
+	}
+
+	// Load all files concurrently
+	Timer_.Start("Get");
+	std::vector<int> rets(Files_.size(), 0);
+	parallelFor(Files_.size(), jobs, [&](size_t file) {
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, fileNames[file]);
+
+		if(Files_[file]->Get(fileNames[file].c_str(), topModule))
+		{
+			nfiError("fileGet failed for %s\n", fileNames[file].c_str());
+			rets[file] = -1;
+		}
+	});
+
+	if(RetsCheck(rets))
+	{
+		return -1;
+	}
+
+	// Find structure, comments and modules of all files concurrently
+	Timer_.Start("IndexCreate");
+	parallelFor(Files_.size(), jobs, [&](size_t file) {
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, fileNames[file]);
+
+		if(Files_[file]->IndexCreate())
+		{
+			nfiError("IndexCreate failed for %s\n", fileNames[file].c_str());
+			rets[file] = -1;
+		}
+	});
+
+	Timer_.Stop();
+
+	return RetsCheck(rets);
+}
+
+// Returns -1 if any of rets, i.e. the return values of parallel jobs, is non-zero
+int RtlDesign::RetsCheck(const std::vector<int> &rets)
+{
+	for(const auto &ret: rets)
+	{
+		if(ret)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+size_t RtlDesign::Size() const
+{
+	size_t size = 0;
+	for(const auto &file: Files_)
+	{
+		size += file->Size_;
+	}
+
+	return size;
+}
+
+// Applies diffs[file] to each file concurrently
+int RtlDesign::DiffsApply(std::vector<RtlFile::diffList_t> &diffs, size_t jobs)
+{
+	std::vector<int> rets(Files_.size(), 0);
+	parallelFor(Files_.size(), jobs, [&](size_t file) {
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, Files_[file]->Name_);
+
+		if(Files_[file]->DiffApply(diffs[file]))
+		{
+			nfiError("DiffApply failed for %s\n", Files_[file]->Name_.c_str());
+			rets[file] = -1;
+		}
+	});
+
+	return RetsCheck(rets);
+}
+
+// Interns the module names of all files into the module table
+int RtlDesign::ModulesIntern()
+{
+	std::vector<moduleName_t> names;
+	for(const auto &file: Files_)
+	{
+		for(auto &entry: file->ModuleIndex_)
+		{
+			names.push_back({entry.Name, &entry.Id, &file->Name_});
+		}
+	}
+
+	return ModuleTableCreate(&Modules_, names, TopModule_);
+}
+
+int RtlDesign::ModuleTableCreate(RtlFile::moduleTable_t * modules, std::vector<moduleName_t> &names, const std::string &topModule)
+{
+	if(RtlFile::ModuleIdNone_ <= names.size())
+	{
+		nfiError("Too many modules: %lu\n", names.size());
+		return -1;
+	}
+
+	size_t poolSize = 0;
+	for(const auto &name: names)
+	{
+		poolSize += name.Name.size();
+	}
+
+	std::stable_sort(names.begin(), names.end(),
+			[](const moduleName_t &a, const moduleName_t &b) { return a.Name < b.Name; });
+
+	*modules = RtlFile::moduleTable_t();
+	modules->NamePool.reserve(poolSize); // views into the pool must stay valid
+	modules->Modules.resize(names.size());
+	modules->Ids.reserve(names.size());
+
+	for(size_t id = 0; id < names.size(); id++)
+	{
+		if((0 < id) && (names[id - 1].Name == names[id].Name))
+		{
+			nfiError("Module %.*s of %s already in modules\n", (int) names[id].Name.size(), names[id].Name.data(),
+					names[id].File->c_str());
+			return -1;
+		}
+
+		const size_t offset = modules->NamePool.size();
+		modules->NamePool.append(names[id].Name);
+
+		RtlFile::module_t &module = modules->Modules[id];
+		module.Name = std::string_view(modules->NamePool.data() + offset, names[id].Name.size());
+		module.EdgesStart = 0;
+		module.EdgesCnt = 0;
+
+		modules->Ids[module.Name] = id;
+		*names[id].Id = id;
+	}
+
+	const auto topIt = modules->Ids.find(topModule);
+	if(modules->Ids.end() == topIt)
+	{
+		nfiError("Could not find module %s\n", topModule.c_str());
+		return -1;
+	}
+
+	modules->Top = topIt->second;
+
+	return 0;
+}
+
+// Stores the resolved instances of all modules as edges, grouped by instantiating module
+void RtlDesign::HierarchyCreate()
+{
+	for(const auto &file: Files_)
+	{
+		for(size_t index = 0; index < file->ModuleIndex_.size(); index++)
+		{
+			size_t edgesCnt = 0;
+			for(const auto &instance: file->Instances_[index])
+			{
+				if(RtlFile::ModuleIdNone_ == instance.Module)
+				{
+					break; // only instances of other modules follow
+				}
+
+				edgesCnt++;
+			}
+
+			Modules_.Modules[file->ModuleIndex_[index].Id].EdgesCnt = edgesCnt;
+		}
+	}
+
+	size_t edgesStart = 0;
+	for(auto &module: Modules_.Modules)
+	{
+		module.EdgesStart = edgesStart;
+		edgesStart += module.EdgesCnt;
+	}
+
+	Modules_.EdgeModules.resize(edgesStart);
+	Modules_.EdgeUuids.assign(edgesStart, 0);
+
+	for(const auto &file: Files_)
+	{
+		for(size_t index = 0; index < file->ModuleIndex_.size(); index++)
+		{
+			const RtlFile::module_t &module = Modules_.Modules[file->ModuleIndex_[index].Id];
+			for(size_t inst = 0; inst < module.EdgesCnt; inst++)
+			{
+				Modules_.EdgeModules[module.EdgesStart + inst] = file->Instances_[index][inst].Module;
+			}
+		}
+	}
+}
+
+int RtlDesign::FiSignalsCreate(RtlFile::fiMode_t fiMode, size_t jobs, FiCache * cache)
+{
+	nfiDebug("Create fi signals for all modules\n");
+
+	// Get all module names, of all files
+	Timer_.Start("ModulesIntern");
+	if(ModulesIntern())
+	{
+		nfiError("ModulesIntern failed\n");
+		return -1;
+	}
+
+	// Parse all files concurrently, instances are resolved across files
+	Timer_.Start("Statements");
+	std::vector<int> rets(Files_.size(), 0);
+	parallelFor(Files_.size(), jobs, [&](size_t file) {
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, Files_[file]->Name_);
+
+		Files_[file]->YosysJsonSet(Json_);
+		Files_[file]->KeysCreate(fiMode, cache);
+
+		if(Files_[file]->StatementsCreate(Timer_.ProfilerGet()))
+		{
+			nfiError("StatementsCreate failed for %s\n", Files_[file]->Name_.c_str());
+			rets[file] = -1;
+		}
+		else if(Files_[file]->InstancesResolve(Modules_))
+		{
+			nfiError("InstancesResolve failed for %s\n", Files_[file]->Name_.c_str());
+			rets[file] = -1;
+		}
+	});
+
+	if(RetsCheck(rets))
+	{
+		return -1;
+	}
+
+	// Get module instance hierarchy, UUIDs are set further below
+	Timer_.Start("Hierarchy");
+	HierarchyCreate();
+	RtlFile::ReachableMark(&Modules_);
+
+	// Cached modules keep their UUIDs, so do changed ones if they still line up, everything else is numbered above them
+	std::unordered_set<size_t> uuidsKept;
+	for(const auto &file: Files_)
+	{
+		file->UuidsCachedGet(&uuidsKept, Modules_);
+	}
+
+	ModulesKeptCnt_ = 0;
+	for(const auto &file: Files_)
+	{
+		ModulesKeptCnt_ += file->UuidsStaleKeep(&uuidsKept, Modules_);
+	}
+
+	size_t uuidNext = RtlFile::UuidFirst_;
+	for(const size_t uuid: uuidsKept)
+	{
+		uuidNext = std::max(uuidNext, uuid + 1);
+	}
+
+	// Fault sites of a module get consecutive UUIDs in text order, modules in file order
+	// Computed up front, so modules may be instrumented in any order
+	// Modules not instantiated below the top are left as they are
+	// Modules with the same body but for the name, e.g. parametrizations resolving alike, are instrumented
+	// once and replayed on the others
+	typedef struct {
+		size_t File;
+		size_t Index; // in module index of file
+		RtlFile::moduleId_t Module;
+		size_t UuidBase;
+		size_t Replay; // job with the same body instrumented, SIZE_MAX if this one is
+	} job_t;
+
+	std::vector<job_t> fiJobs;
+	std::unordered_map<uint64_t, std::vector<size_t>> bodies; // key -> jobs instrumented
+	size_t replaysCnt = 0;
+	ModulesCachedCnt_ = 0;
+	for(size_t file = 0; file < Files_.size(); file++)
+	{
+		for(size_t index = 0; index < Files_[file]->ModuleIndex_.size(); index++)
+		{
+			const RtlFile::moduleIndex_t &entry = Files_[file]->ModuleIndex_[index];
+			if(!Modules_.Modules[entry.Id].Reachable)
+			{
+				continue;
+			}
+
+			size_t replay = SIZE_MAX;
+			if(nullptr == Files_[file]->Cached_[index])
+			{
+				// Keys may collide, so the bodies are compared
+				std::vector<size_t> &same = bodies[Files_[file]->Keys_[index]];
+				for(const size_t job: same)
+				{
+					if(Files_[file]->BodyEqual(index, *Files_[fiJobs[job].File], fiJobs[job].Index))
+					{
+						replay = job;
+						replaysCnt++;
+						break;
+					}
+				}
+
+				if(SIZE_MAX == replay)
+				{
+					same.push_back(fiJobs.size());
+				}
+			}
+
+			const FiCache::entry_t * const stale = Files_[file]->Stale_[index];
+			if(nullptr != Files_[file]->Cached_[index])
+			{
+				fiJobs.push_back({file, index, entry.Id, uuidNext, replay});
+				ModulesCachedCnt_++;
+			}
+			else if(nullptr != stale)
+			{
+				fiJobs.push_back({file, index, entry.Id, stale->Sites.empty() ? uuidNext : stale->Sites[0].UUID, replay});
+			}
+			else
+			{
+				fiJobs.push_back({file, index, entry.Id, uuidNext, replay});
+				uuidNext += entry.AssignmentsCnt;
+			}
+		}
+	}
+
+	nfiDebug("%lu of %lu modules replayed from a module with the same body\n", replaysCnt, fiJobs.size());
+
+	CacheUsed_ = (nullptr != cache);
+	ModulesReachableCnt_ = fiJobs.size();
+
+	// Add fiEnable to each module's input and corruption signal to all assignments
+	// Each module gets its own diff, they are concatenated in module order, i.e. already sorted
+	// Replays need the fault sites of their module, so they run after all others
+	Timer_.Start("ModuleFi");
+	std::vector<RtlFile::diffList_t> moduleDiffs(fiJobs.size());
+	for(auto &diff: moduleDiffs)
+	{
+		diff.Text.MeasureSet(Analyze_);
+	}
+
+	ModulesGrowth_.assign(Analyze_ ? Modules_.Modules.size() : 0, 0);
+	rets.assign(fiJobs.size(), 0);
+	for(const bool replays: {false, true})
+	{
+		parallelFor(fiJobs.size(), jobs, [&](size_t job) {
+			const job_t &fiJob = fiJobs[job];
+			if(replays != (SIZE_MAX != fiJob.Replay))
+			{
+				return;
+			}
+
+			Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryModule, Files_[fiJob.File]->ModuleIndex_[fiJob.Index].Name);
+
+			RtlFile::module_t * module = &Modules_.Modules[fiJob.Module];
+			if(!replays)
+			{
+				rets[job] = Files_[fiJob.File]->ModuleFiRun(fiJob.Index, fiMode, module, fiJob.UuidBase, &moduleDiffs[job]);
+			}
+			else if(rets[fiJob.Replay])
+			{
+				rets[job] = -1;
+			}
+			else
+			{
+				const job_t &replayJob = fiJobs[fiJob.Replay];
+				const RtlFile::replay_t replay = Files_[replayJob.File]->ReplayGet(replayJob.Index, &Modules_.Modules[replayJob.Module], replayJob.UuidBase);
+				rets[job] = Files_[fiJob.File]->ModuleFiReplay(fiJob.Index, fiMode, module, fiJob.UuidBase, &moduleDiffs[job], replay);
+			}
+
+			if(Analyze_)
+			{
+				ModulesGrowth_[fiJob.Module] = RtlFile::DiffGrowthGet(moduleDiffs[job]);
+			}
+		});
+
+		if(0 == replaysCnt)
+		{
+			break;
+		}
+	}
+
+	// Analyzed modules are only measured, their edits are not needed any more
+	std::vector<RtlFile::diffList_t> fileDiffs(Files_.size());
+	FilesGrowth_.assign(Analyze_ ? Files_.size() : 0, 0);
+	for(size_t job = 0, file = 0; file < Files_.size(); file++)
+	{
+		size_t editsCnt = 0;
+		for(size_t next = job; !Analyze_ && (next < fiJobs.size()) && (file == fiJobs[next].File); next++)
+		{
+			editsCnt += moduleDiffs[next].Edits.size();
+		}
+
+		RtlFile::diffList_t &diff = fileDiffs[file];
+		diff.Text.MeasureSet(Analyze_);
+		diff.Edits.reserve(editsCnt);
+		for(; (job < fiJobs.size()) && (file == fiJobs[job].File); job++)
+		{
+			if(rets[job])
+			{
+				nfiError("ModuleFiRun failed\n");
+				return -1;
+			}
+
+			if(Analyze_)
+			{
+				FilesGrowth_[file] += ModulesGrowth_[fiJobs[job].Module];
+				continue;
+			}
+
+			diff.Edits.insert(diff.Edits.end(), moduleDiffs[job].Edits.begin(), moduleDiffs[job].Edits.end());
+			diff.Text.Adopt(std::move(moduleDiffs[job].Text));
+			moduleDiffs[job].Edits = std::vector<RtlFile::diff_t>(); // release early
+		}
+	}
+
+	if(!Analyze_)
+	{
+		Timer_.Start("DiffApply");
+		if(DiffsApply(fileDiffs, jobs))
+		{
+			nfiError("DiffsApply of fault sites failed\n");
+			return -1;
+		}
+	}
+
+	// Subtree totals need the fault sites of all modules
+	Timer_.Start("HierarchyAnalyze");
+	if(RtlFile::HierarchyAnalyze(&Modules_))
+	{
+		nfiError("HierarchyAnalyze failed\n");
+		return -1;
+	}
+
+	const size_t hierarchyDepth = Modules_.Modules[Modules_.Top].SubtreeDepth;
+	const size_t largestWidth = RtlFile::LargestWidthGet(Modules_);
+
+	// Associate UUID to each module instance and set fiEnable input
+	// Sequential, as instance UUIDs are handed out in file order
+	Timer_.Start("InstancesWire");
+	for(size_t file = 0; file < Files_.size(); file++)
+	{
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, Files_[file]->Name_);
+
+		if(Files_[file]->InstancesWire(&fileDiffs[file], &Modules_, hierarchyDepth, largestWidth, &uuidNext))
+		{
+			nfiError("InstancesWire failed for %s\n", Files_[file]->Name_.c_str());
+			return -1;
+		}
+
+		if(UnreachableDrop_)
+		{
+			Files_[file]->UnreachableDrop(&fileDiffs[file], Modules_);
+		}
+	}
+
+	if(Analyze_)
+	{
+		for(size_t file = 0; file < Files_.size(); file++)
+		{
+			FilesGrowth_[file] += RtlFile::DiffGrowthGet(fileDiffs[file]);
+		}
+
+		Timer_.Stop();
+
+		return 0;
+	}
+
+	Timer_.Start("DiffApply");
+	if(DiffsApply(fileDiffs, jobs))
+	{
+		nfiError("DiffsApply of instances failed\n");
+		return -1;
+	}
+
+	// Create library with module hierarchy etc.
+	Timer_.Start("LibraryCreate");
+	if(RtlFile::LibraryCreate(Modules_, TopModule_, Library_))
+	{
+		nfiError("libraryCreate failed\n");
+		return -1;
+	}
+
+	if(nullptr != cache)
+	{
+		// Cached modules are copied over from the old cache
+		Timer_.Start("CacheUpdate");
+		FiCache updated;
+		updated.TopSet(TopModule_);
+		for(const auto &file: Files_)
+		{
+			if(file->CacheUpdate(&updated, Modules_))
+			{
+				nfiError("CacheUpdate failed for %s\n", file->Name_.c_str());
+				return -1;
+			}
+		}
+
+		*cache = std::move(updated);
+	}
+
+	Timer_.Stop();
+
+	return 0;
+}
+
+int RtlDesign::HierarchyPrint(FILE * file) const
+{
+	if(RtlFile::HierarchyPrint(file, Modules_))
+	{
+		nfiError("HierarchyPrint failed\n");
+		return -1;
+	}
+
+	if(CacheUsed_ && (0 > fprintf(file, "Cache: %lu of %lu modules unchanged, %lu changed keep their UUIDs\n",
+			ModulesCachedCnt_, ModulesReachableCnt_, ModulesKeptCnt_)))
+	{
+		nfiError("fprintf failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int RtlDesign::AnalysisPrint(FILE * file) const
+{
+	if(Modules_.Modules.size() <= Modules_.Top)
+	{
+		nfiError("No top module\n");
+		return -1;
+	}
+
+	const RtlFile::module_t &top = Modules_.Modules[Modules_.Top];
+
+	size_t sitesCnt = 0;
+	size_t unreachableCnt = 0;
+	for(const auto &module: Modules_.Modules)
+	{
+		sitesCnt += module.FiSignal.size();
+		unreachableCnt += module.Reachable ? 0 : 1;
+	}
+
+	ptrdiff_t growth = 0;
+	for(const auto &fileGrowth: FilesGrowth_)
+	{
+		growth += fileGrowth;
+	}
+
+	std::string name;
+	Profiler::JsonEscape(&name, TopModule_);
+
+	int ret = fprintf(file, "{\n\"top\": \"%s\",\n\"hierarchyDepth\": %lu,\n\"moduleInstances\": %lu,\n"
+			"\"faultSites\": %lu,\n\"faultBits\": %lu,\n\"largestWidth\": %lu,\n\"unreachableModules\": %lu,\n"
+			"\"inputBytes\": %lu,\n\"growthBytes\": %td,\n\"files\": [\n",
+			name.c_str(), top.SubtreeDepth, top.SubtreeInstances,
+			sitesCnt, top.SubtreeBits, RtlFile::LargestWidthGet(Modules_), unreachableCnt,
+			Size(), growth);
+
+	for(size_t nr = 0; (0 <= ret) && (nr < Files_.size()); nr++)
+	{
+		Profiler::JsonEscape(&name, Files_[nr]->Name_);
+		ret = fprintf(file, "{\"name\": \"%s\", \"bytes\": %lu, \"growthBytes\": %td}%s\n",
+				name.c_str(), Files_[nr]->Size_, FilesGrowth_[nr], (nr + 1 < Files_.size()) ? "," : "");
+	}
+
+	if(0 <= ret)
+	{
+		ret = fprintf(file, "],\n\"modules\": [\n");
+	}
+
+	// Instrumented modules in file order, with the fault sites of the module itself and totals of all instances below
+	const char * separator = "";
+	std::string fileName;
+	for(size_t nr = 0; (0 <= ret) && (nr < Files_.size()); nr++)
+	{
+		Profiler::JsonEscape(&fileName, Files_[nr]->Name_);
+		for(size_t index = 0; (0 <= ret) && (index < Files_[nr]->ModuleIndex_.size()); index++)
+		{
+			const RtlFile::moduleId_t id = Files_[nr]->ModuleIndex_[index].Id;
+			const RtlFile::module_t &module = Modules_.Modules[id];
+			if(!module.Reachable)
+			{
+				continue;
+			}
+
+			size_t bits = 0;
+			for(const auto &signal: module.FiSignal)
+			{
+				bits += signal.Width;
+			}
+
+			Profiler::JsonEscape(&name, module.Name);
+			ret = fprintf(file, "%s{\"name\": \"%s\", \"file\": \"%s\", \"sites\": %lu, \"bits\": %lu, \"instances\": %lu, "
+					"\"subtreeDepth\": %lu, \"subtreeInstances\": %lu, \"subtreeBits\": %lu, \"growthBytes\": %td}",
+					separator, name.c_str(), fileName.c_str(), module.FiSignal.size(), bits, module.EdgesCnt,
+					module.SubtreeDepth, module.SubtreeInstances, module.SubtreeBits, ModulesGrowth_[id]);
+			separator = ",\n";
+		}
+	}
+
+	if(0 <= ret)
+	{
+		ret = fprintf(file, "\n]\n}\n");
+	}
+
+	if(0 > ret)
+	{
+		nfiError("Writing the analysis failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int RtlDesign::WriteBack(size_t jobs)
+{
+	// Files written to stdout follow each other in order
+	for(const auto &file: Files_)
+	{
+		if(0 == strcmp(file->Output().c_str(), RtlFile::StdioName))
+		{
+			jobs = 1;
+		}
+	}
+
+	Timer_.Start("WriteBack");
+	std::vector<int> rets(Files_.size(), 0);
+	parallelFor(Files_.size(), jobs, [&](size_t file) {
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, Files_[file]->Name_);
+
+		if(!Files_[file]->Edited() && Files_[file]->Output().empty())
+		{
+			nfiDebug("%s unchanged, not written\n", Files_[file]->Name().c_str());
+			return;
+		}
+
+		if(Files_[file]->WriteBack())
+		{
+			nfiError("WriteBack failed for %s\n", Files_[file]->Name().c_str());
+			rets[file] = -1;
+		}
+	});
+
+	Timer_.Stop();
+
+	return RetsCheck(rets);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef RTLDESIGN_H_
+#define RTLDESIGN_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FiCache.h"
+#include "PhaseTimer.h"
+#include "RtlFile.h"
+
+// Netlist split over one or more files, e.g. one per partition.
+// Module hierarchy and UUIDs span all files, each file is written back on its own.
+class RtlDesign {
+public:
+	// Files are written to output instead of back, see RtlFile::OutputName, the library to library if set
+	// To be called before Get
+	void OutputSet(const std::string &output, const std::string &library);
+
+	// Modules not instantiated below the top module are removed instead of left as they are
+	void UnreachableDropSet(bool drop) { UnreachableDrop_ = drop; }
+
+	// Fault sites are found and the growth of the netlist measured, but nothing is edited or written, see AnalysisPrint
+	// A cache is read, but not updated
+	void AnalyzeSet(bool analyze) { Analyze_ = analyze; }
+
+	// Widths of nets are taken from json where it has the module, see RtlFile::YosysJsonSet
+	void YosysJsonSet(const YosysJson * json) { Json_ = json; }
+
+	// paths are files or directories, of which all *.v files are taken, "-" is stdin
+	int Get(const std::vector<std::string> &paths, const std::string &topModule, size_t jobs = 1);
+
+	// Unchanged modules found in cache are taken from there, the cache is updated with this run
+	int FiSignalsCreate(RtlFile::fiMode_t fiMode, size_t jobs = 1, FiCache * cache = nullptr);
+
+	// Files without any module are not rewritten, unless written to another output
+	int WriteBack(size_t jobs = 1);
+
+	// Phases of Get, FiSignalsCreate and WriteBack so far
+	PhaseTimer &Timer() { return Timer_; }
+
+	size_t Size() const; // bytes of all files
+
+	// Depth, instances and fault bits of the expanded hierarchy, once instrumented
+	// With a cache, also how many modules were taken from it
+	int HierarchyPrint(FILE * file) const;
+
+	// JSON report of the fault space and the predicted growth of each module and file, once analyzed
+	int AnalysisPrint(FILE * file) const;
+
+	// Module of a file, to be interned into a module table
+	typedef struct {
+		std::string_view Name;
+		RtlFile::moduleId_t * Id; // set to the id of Name
+		const std::string * File; // containing the module
+	} moduleName_t;
+
+	// Ids follow the sorted names, duplicate names and a missing top module are errors
+	static int ModuleTableCreate(RtlFile::moduleTable_t * modules, std::vector<moduleName_t> &names, const std::string &topModule);
+
+	static int RetsCheck(const std::vector<int> &rets);
+
+	static int PathsExpand(std::vector<std::string> * fileNames, const std::vector<std::string> &paths);
+
+	// Files must not share an output, other than stdout
+	static int OutputsCheck(const std::vector<std::string> &fileNames, const std::string &output);
+
+private:
+	std::vector<std::unique_ptr<RtlFile>> Files_; // in order of paths, UUIDs are handed out in this order
+	std::string TopModule_;
+	std::string Output_; // empty if written back
+	std::string Library_; // empty for the default name
+	bool UnreachableDrop_ = false;
+	bool Analyze_ = false;
+	const YosysJson * Json_ = nullptr;
+
+	RtlFile::moduleTable_t Modules_; // of all files
+
+	PhaseTimer Timer_;
+
+	// Of the reachable modules, how many were cached or keep their UUIDs, if instrumented with a cache
+	bool CacheUsed_ = false;
+	size_t ModulesReachableCnt_ = 0;
+	size_t ModulesCachedCnt_ = 0;
+	size_t ModulesKeptCnt_ = 0;
+
+	// Bytes added if instrumented, only if analyzed
+	std::vector<ptrdiff_t> ModulesGrowth_; // by module id, by its fault sites and fiEnable input
+	std::vector<ptrdiff_t> FilesGrowth_; // incl. instances and global signals
+
+	int ModulesIntern();
+	void HierarchyCreate();
+	int DiffsApply(std::vector<RtlFile::diffList_t> &diffs, size_t jobs);
+};
+
+#endif /* RTLDESIGN_H_ */
@@ -19,20 +19,23 @@
  */
 
 #include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
 
 #include "common.h"
 
 #include "RtlFile.h"
+#include "YosysJson.h"
 
 #define FI_SINGLE_BIT 0
 
-static size_t uuidGet()
-{
-	static size_t counter = 2; // 1 is reserved, see GlobalFiModInstNumberTop_
-	return counter++;
-}
-
-static void backslashToDoubleBackslash(std::string * out, const std::string & in)
+static void backslashToDoubleBackslash(std::string * out, std::string_view in)
 {
 	out->resize(0);
 	out->reserve(2 * in.size());
@@ -56,10 +59,86 @@ RtlFile::RtlFile() {
 }
 
 RtlFile::~RtlFile() {
-	if(nullptr != Content_)
+	ContentRelease();
+}
+
+void RtlFile::ContentRelease()
+{
+	if(nullptr != Mapping_)
+	{
+		munmap(Mapping_, MappingSize_);
+		Mapping_ = nullptr;
+		MappingSize_ = 0;
+	}
+
+	if(nullptr != Buffer_)
+	{
+		free(Buffer_);
+		Buffer_ = nullptr;
+	}
+
+	Content_ = nullptr;
+	Size_ = 0;
+}
+
+// Fallback for files that can't be mapped, e.g. pipes or compressed files
+// The structural index is built while reading, i.e. while compressed files are decompressed on another thread
+int RtlFile::FileRead(int fd)
+{
+	Decompressor decompressor;
+	if(decompressor.Open(fd, Name_.c_str()))
+	{
+		nfiError("Decompressor::Open failed for %s\n", Name_.c_str());
+		return -1;
+	}
+
+	Compression_ = decompressor.Type();
+
+	size_t capacity = 1 << 20;
+	Buffer_ = (char *) malloc(capacity);
+	if(nullptr == Buffer_)
+	{
+		nfiError("Could not malloc %lu bytes for %s\n", capacity, Name_.c_str());
+		return -1;
+	}
+
+	size_t size = 0;
+	while(true)
 	{
-		free(Content_);
+		if(size == capacity)
+		{
+			capacity *= 2;
+			char * newBuffer = (char *) realloc(Buffer_, capacity);
+			if(nullptr == newBuffer)
+			{
+				nfiError("Could not realloc %lu bytes for %s\n", capacity, Name_.c_str());
+				return -1;
+			}
+			Buffer_ = newBuffer;
+		}
+
+		const ssize_t readRet = decompressor.Read(Buffer_ + size, capacity - size);
+		if(0 > readRet)
+		{
+			nfiError("Could not read %s\n", Name_.c_str());
+			return -1;
+		}
+		else if(0 == readRet)
+		{
+			break;
+		}
+
+		size += readRet;
+		Structure_.Extend(Buffer_, size, false);
 	}
+
+	Structure_.Extend(Buffer_, size, true);
+	StructureDone_ = true;
+
+	Content_ = Buffer_;
+	Size_ = size;
+
+	return 0;
 }
 
 int RtlFile::Get(const char * fileName, const std::string &topModule)
@@ -72,128 +151,274 @@ int RtlFile::Get(const char * fileName, const std::string &topModule)
 
 	Name_ = fileName;
 
-	FILE * pFile = fopen(fileName, "r");
-	if(nullptr == pFile)
+	const bool stdinUsed = (0 == strcmp(fileName, StdioName));
+	const int fd = stdinUsed ? STDIN_FILENO : open(fileName, O_RDONLY);
+	if(0 > fd)
 	{
 		nfiError("failed to open file %s\n", fileName);
 		return -1;
 	}
 
-	if(fseek(pFile, 0L, SEEK_END))
+	struct stat fileStat;
+	if(fstat(fd, &fileStat))
 	{
-		nfiError("SEEK_END failed on file %s\n", fileName);
-		fclose(pFile); // no write performed, so no need to check
+		nfiError("fstat failed on file %s\n", fileName);
+		if(!stdinUsed)
+		{
+			close(fd);
+		}
 		return -1;
 	}
 
-	const long nFile = ftell(pFile);
-	if(0 > nFile)
+	// Compressed files are read like pipes
+	unsigned char head[Compression::MagicSize];
+	const bool compressed = (sizeof(head) == pread(fd, head, sizeof(head), 0)) &&
+			(Compression::COMPRESSION_NONE != Compression::Detect(head, sizeof(head)));
+
+	if(S_ISREG(fileStat.st_mode) && (0 < fileStat.st_size) && !compressed)
 	{
-		nfiError("ftell failed on file %s\n", fileName);
-		fclose(pFile); // no write performed, so no need to check
-		return -1;
-	}
+		// Map read-only, the text is never copied
+		void * mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(MAP_FAILED == mapping)
+		{
+			nfiError("mmap failed on file %s\n", fileName);
+			if(!stdinUsed)
+			{
+				close(fd);
+			}
+			return -2;
+		}
 
-	rewind(pFile);
+		// Advice only, failure is harmless
+		madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+		madvise(mapping, fileStat.st_size, MADV_WILLNEED);
 
-	Content_ = (char *) malloc(nFile + 1);
-	if(NULL == Content_)
+		Mapping_ = mapping;
+		MappingSize_ = fileStat.st_size;
+		Content_ = (const char *) mapping;
+		Size_ = fileStat.st_size;
+	}
+	else if(FileRead(fd))
 	{
-		nfiError("Could not malloc %lu bytes for %s\n", nFile + 1, fileName);
-		fclose(pFile); // no write performed, so no need to check
-		return -3;
+		nfiError("FileRead failed on file %s\n", fileName);
+		if(!stdinUsed)
+		{
+			close(fd);
+		}
+		ContentRelease();
+		return -4;
 	}
 
-	Size_ = fread(
-			(void *) Content_,
-			sizeof(char), nFile, pFile);
-
-	fclose(pFile); // no write performed, so no need to check
+	if(!stdinUsed)
+	{
+		close(fd); // no write performed, so no need to check
+	}
+	else if(Output_.empty())
+	{
+		Output_ = StdioName; // stdin can't be written back
+	}
 
-	if(Size_ != nFile)
+	if(0 == Size_)
 	{
-		nfiError("Could not read %s\n", fileName);
+		nfiError("File %s is empty\n", fileName);
+		ContentRelease();
 		return -4;
 	}
 
-	Content_[Size_] = '\0';
-	Size_++;
-
 	TopModule_ = topModule;
 
 	return 0;
 }
 
-static const char * strrstr(const char * haystack, const char * pos, const char * needle)
+void RtlFile::WindowSet(const std::string &name, const std::string &topModule, const char * content, size_t size, bool last)
 {
-	const size_t needleLen = strlen(needle);
+	ContentRelease();
+
+	Name_ = name;
+	TopModule_ = topModule;
+	Content_ = content;
+	Size_ = size;
+	Partial_ = !last;
+	StructureDone_ = false;
+
+	Pieces_.clear();
+	Replacements_ = TextArena();
+}
 
-	if(needleLen > pos - haystack)
+// Bounded counterpart of strchr, Content_ is not '\0' terminated
+static const char * rangeFindChar(const char * start, const char * stop, char needle)
+{
+	if(start >= stop)
 	{
 		return nullptr;
 	}
 
-	const char * currPos = pos - needleLen;
-	while(currPos - needleLen > haystack)
-	{
-		if(0 == strncmp(currPos, needle, needleLen))
-		{
-			return currPos;
-		}
-		currPos--;
-	}
+	return (const char *) memchr(start, needle, stop - start);
+}
 
-	return nullptr;
+static bool rangeStartsWith(const char * pos, const char * stop, const char * str)
+{
+	const size_t len = strlen(str);
+
+	return (len <= (size_t) (stop - pos)) && (0 == memcmp(pos, str, len));
 }
 
-bool RtlFile::PosInsideComment(const char * pos, const char * start, const char * end)
+static bool isWhiteSpace(char c)
 {
-	// Inside block comment?
-	for(size_t blockType = 0; blockType < sizeof(blockCommentStartStr) / sizeof(blockCommentStartStr[0]); blockType++)
+	return (' ' == c) || ('\t' == c) || ('\n' == c) || ('\r' == c) || ('\f' == c);
+}
+
+// Collects block comments, attributes and line comments of Content_ from the structural index
+int RtlFile::CommentIndexCreate()
+{
+	CommentIndex_.clear();
+
+	// Escaped identifiers and strings may contain comment starts, so they are skipped as well
+	static constexpr StructuralIndex::structural_t openers[] = {
+			StructuralIndex::STRUCT_BACKSLASH,
+			StructuralIndex::STRUCT_QUOTE,
+			StructuralIndex::STRUCT_LINE_COMMENT,
+			StructuralIndex::STRUCT_ATTRIBUTE, // ends with blockCommentEndStr[0]
+			StructuralIndex::STRUCT_BLOCK_COMMENT // ends with blockCommentEndStr[1]
+	};
+	static constexpr size_t openersNrof = sizeof(openers) / sizeof(openers[0]);
+
+	const char * const end = Content_ + Size_;
+	size_t cursor[openersNrof] = {0};
+	size_t offset = 0;
+	while(true)
 	{
-		// Find next block end
-		const char * blockEnd = strstr(pos, blockCommentEndStr[blockType]);
-		if((nullptr != blockEnd) && (blockEnd < end))
+		// Next opener at or after offset
+		size_t next = SIZE_MAX;
+		size_t nextOpener = openersNrof;
+		for(size_t opener = 0; opener < openersNrof; opener++)
 		{
-			// Is that blockEnd opened before pos?
-			const char * blockStart = strrstr(pos, blockEnd, blockCommentStartStr[blockType]);
-			if(nullptr == blockStart)
+			const std::vector<size_t> &positions = Structure_.Positions(openers[opener]);
+			while((cursor[opener] < positions.size()) && (positions[cursor[opener]] < offset))
+			{
+				cursor[opener]++;
+			}
+
+			if((cursor[opener] < positions.size()) && (positions[cursor[opener]] < next))
 			{
-				return true;
+				next = positions[cursor[opener]];
+				nextOpener = opener;
 			}
 		}
-	}
 
-	// Inside line comment?
-	const char * currPos = pos;
-	do {
-		if('\n' == *currPos)
+		if(SIZE_MAX == next)
 		{
 			break;
 		}
 
-		if(('/' == *currPos) && ('/' == *(currPos - 1)))
+		const char * const regionStart = Content_ + next;
+		const char * pos = regionStart;
+
+		switch(openers[nextOpener])
 		{
-			return true;
+		case StructuralIndex::STRUCT_BACKSLASH:
+			// Escaped identifier, may contain anything up to white space
+			while((pos < end) && !isWhiteSpace(*pos))
+			{
+				pos++;
+			}
+			break;
+
+		case StructuralIndex::STRUCT_QUOTE:
+			// String literal, only skipped
+			pos++;
+			while((pos < end) && ('"' != *pos))
+			{
+				pos += ('\\' == *pos) ? 2 : 1;
+			}
+			pos++;
+			break;
+
+		case StructuralIndex::STRUCT_LINE_COMMENT:
+			pos = (const char *) memchr(pos, '\n', end - pos);
+			if(nullptr == pos)
+			{
+				pos = end;
+			}
+
+			CommentIndex_.push_back({regionStart - Content_, pos - Content_});
+			break;
+
+		default:
+		{
+			const size_t blockType = (StructuralIndex::STRUCT_ATTRIBUTE == openers[nextOpener]) ? 0 : 1;
+
+			// "@(*)" is no attribute
+			if((0 == blockType) && (pos + 2 < end) && (')' == pos[2]))
+			{
+				pos++;
+				break;
+			}
+
+			// Strings in attributes may contain the block end
+			pos += 2;
+			while((pos < end) && !rangeStartsWith(pos, end, blockCommentEndStr[blockType]))
+			{
+				if('"' == *pos)
+				{
+					pos++;
+					while((pos < end) && ('"' != *pos))
+					{
+						pos += ('\\' == *pos) ? 2 : 1;
+					}
+				}
+				pos++;
+			}
+
+			// A partial window may end within the comment, it continues in the next window
+			if((end <= pos) && !Partial_)
+			{
+				nfiError("Comment doesn't end: %.30s\n", regionStart);
+				return -1;
+			}
+
+			pos = std::min(pos + 2, end); // after block end
+			CommentIndex_.push_back({regionStart - Content_, pos - Content_});
+		}
+			break;
 		}
 
-		currPos--;
+		offset = pos - Content_;
+	}
+
+	return 0;
+}
+
+bool RtlFile::PosInsideComment(const char * pos) const
+{
+	Profiler::Count(Profiler::COUNTER_COMMENT_CHECKS);
 
-	} while(currPos > start);
+	const size_t offset = pos - Content_;
 
+	// Last region starting at or before pos
+	auto it = std::upper_bound(CommentIndex_.begin(), CommentIndex_.end(), offset,
+			[](size_t off, const std::pair<size_t, size_t> &region) { return off < region.first; });
+	if(CommentIndex_.begin() == it)
+	{
+		return false;
+	}
 
-	return false;
+	it--;
+
+	return offset < it->second;
 }
 
 // Returns negative on error, positive when module was found
 // start	Pointer to module start (after name)
 // end		Pointer to module end (after "endmodule")
-int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** end, const char * pFile, size_t nFile)
+int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** end, const char * pFile, size_t nFile) const
 {
 	const char modStartStr[] = "module ";
 	const char modEndStr[] = "endmodule";
 
-	const char * modStart = strstr(pFile, modStartStr); // TODO: no strnstr?!?
+	const char * const fileEnd = pFile + nFile;
+
+	const char * modStart = StructNext(StructuralIndex::STRUCT_MODULE, pFile, fileEnd);
 	if(nullptr == modStart)
 	{
 		return 0; // no module in this file
@@ -202,23 +427,19 @@ int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** e
 	modStart += sizeof(modStartStr) - 1; // -1 for '\0'
 
 	// Module name either ends with # or with (
-	const char * modNameEndHash = strchr(modStart, '#');
-	const char * modNameEndParenth = strchr(modStart, '(');
-
-	const char * modNameEnd = NULL;
-	if((NULL != modNameEndHash) && (NULL != modNameEndParenth))
-	{
-		modNameEnd = modNameEndHash < modNameEndParenth ? modNameEndHash : modNameEndParenth;
-	}
-	else if(NULL != modNameEndHash)
+	// Stop at whichever comes first, scanning for each separately runs to the end of file
+	const char * modNameEnd = modStart;
+	while((modNameEnd < fileEnd) && ('#' != *modNameEnd) && ('(' != *modNameEnd))
 	{
-		modNameEnd = modNameEndHash;
+		modNameEnd++;
 	}
-	else if(NULL != modNameEndParenth)
+
+	if((fileEnd == modNameEnd) && Partial_)
 	{
-		modNameEnd = modNameEndParenth;
+		return 0; // module continues in the next window
 	}
-	else
+
+	if(fileEnd == modNameEnd)
 	{
 		nfiError("Could not find module name in %.30s\n", modStart);
 		return -5;
@@ -253,7 +474,7 @@ int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** e
 	modNameEnd++; // be one after end again
 
 	// Module inside comment?
-	if(PosInsideComment(modStart, pFile, pFile + nFile))
+	if(PosInsideComment(modStart))
 	{
 		return ModuleFind(name, start, end, modStart, nFile - (modStart - pFile));
 	}
@@ -279,7 +500,12 @@ int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** e
 	*start = modNameEnd;
 
 	// Find module end
-	const char * modEnd = strstr(pFile, modEndStr); // TODO: no strnstr?!?
+	const char * modEnd = StructNext(StructuralIndex::STRUCT_ENDMODULE, pFile, fileEnd);
+	if((nullptr == modEnd) && Partial_)
+	{
+		return 0; // module continues in the next window
+	}
+
 	if(nullptr == modEnd)
 	{
 		nfiError("module doesn't end: %s\n", name->c_str());
@@ -288,13 +514,19 @@ int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** e
 
 	modEnd += sizeof(modEndStr) - 1; // -1 for '\0'
 
-	if(modEnd >= pFile + nFile)
+	if(modEnd > fileEnd)
 	{
 		nfiError("module ends after end of file: %s\n", name->c_str());
 		return -2;
 	}
 
-	if(nullptr != strrstr(modNameEnd, modEnd, modStartStr))
+	const char * innerModule = StructNext(StructuralIndex::STRUCT_MODULE, modNameEnd, modEnd - (sizeof(modEndStr) - 1));
+	while((nullptr != innerModule) && PosInsideComment(innerModule))
+	{
+		innerModule = StructNext(StructuralIndex::STRUCT_MODULE, innerModule + 1, modEnd - (sizeof(modEndStr) - 1));
+	}
+
+	if(nullptr != innerModule)
 	{
 		nfiError("Module declaration inside module: %s\n", name->c_str());
 		return -3;
@@ -305,42 +537,135 @@ int RtlFile::ModuleFind(std::string * name, const char ** start, const char ** e
 	return 1;
 }
 
-const char * RtlFile::NextNeedle(size_t * needleNr, const char * pHaystack, size_t nHaystack)
+// Returns position of ");" closing the module port list, nullptr on error
+const char * RtlFile::PortListEndGet(const char * start, const char * stop) const
 {
-	const size_t nNeedles = sizeof(fiNeedles) / sizeof(fiNeedles[0]);
-
-	std::vector<const char *> fiNeedle(nNeedles);
-	for(size_t needle = 0; needle < nNeedles; needle++)
+	// The port list ends with the first ';' of the module
+	const char * semiColon = StructNext(StructuralIndex::STRUCT_SEMICOLON, start, stop);
+	if(nullptr == semiColon)
 	{
-		fiNeedle[needle] = strstr(pHaystack, fiNeedles[needle]);
-		if(fiNeedle[needle] > pHaystack + nHaystack)
-		{
-			fiNeedle[needle] = nullptr;
-		}
+		nfiError("Could not find end of io\n");
+		return nullptr;
 	}
 
-	const char * ret = pHaystack + nHaystack;
-	for(size_t needle = 0; needle < nNeedles; needle++)
+	const char * ioEnd = semiColon - 1;
+	if((ioEnd < start) || (')' != *ioEnd) || PosInsideComment(ioEnd))
 	{
-		if((nullptr != fiNeedle[needle]) && (fiNeedle[needle] < ret))
-		{
-			ret = fiNeedle[needle];
-			*needleNr = needle;
-		}
+		nfiError("Unexpected ';'\n");
+		return nullptr;
 	}
 
-	if(ret == pHaystack + nHaystack)
+	return ioEnd;
+}
+
+// Returns first position of type in [pos, stop) or nullptr
+const char * RtlFile::StructNext(StructuralIndex::structural_t type, const char * pos, const char * stop) const
+{
+	const size_t next = Structure_.Next(type, pos - Content_);
+	if((SIZE_MAX == next) || (stop <= Content_ + next))
 	{
 		return nullptr;
 	}
 
-	// Needle inside comment?
-	if(PosInsideComment(ret, pHaystack, pHaystack + nHaystack))
+	return Content_ + next;
+}
+
+// Single pass over Content_ collecting all module locations
+int RtlFile::ModuleIndexCreate()
+{
+	ModuleIndex_.clear();
+
+	const char * filePos = Content_;
+	do {
+		nfiDebug("Find next module\n");
+		std::string moduleName;
+		const char * moduleStart;
+		const char * moduleEnd;
+		const int modFindRet = ModuleFind(
+				&moduleName, &moduleStart, &moduleEnd,
+				filePos, Size_ - (filePos - Content_));
+
+		if(0 > modFindRet)
+		{
+			nfiError("moduleFind failed\n");
+			return -1;
+		}
+		else if(0 == modFindRet)
+		{
+			break;
+		}
+
+		if(200 < moduleName.size())
+		{
+			nfiError("Module name longer than 200 chars: %.200s\n", moduleName.c_str());
+			return -1;
+		}
+
+		const size_t line = Structure_.CountBefore(StructuralIndex::STRUCT_NEWLINE, moduleStart - Content_) + 1;
+
+		const char * ioEnd = PortListEndGet(moduleStart, moduleEnd);
+		if(nullptr == ioEnd)
+		{
+			nfiError("PortListEndGet failed for module %s (line %lu)\n", moduleName.c_str(), line);
+			return -1;
+		}
+
+		nfiDebug("\tFound module %s (line %lu)\n", moduleName.c_str(), line);
+
+		moduleIndex_t entry;
+		entry.Name = moduleName;
+		entry.Start = moduleStart - Content_;
+		entry.End = moduleEnd - Content_;
+		entry.PortListEnd = ioEnd - Content_;
+		entry.Line = line;
+		entry.Id = ModuleIdNone_; // set once the design's modules are known
+		ModuleIndex_.push_back(entry);
+
+		// Prepare next round
+		filePos = moduleEnd;
+
+	} while(filePos < Content_ + Size_);
+
+	return 0;
+}
+
+const char * RtlFile::NextNeedle(size_t * needleNr, const char * pHaystack, size_t nHaystack) const
+{
+	static constexpr StructuralIndex::structural_t needleTypes[FI_NEEDLE_NROF] = {
+			StructuralIndex::STRUCT_ASSIGN,
+			StructuralIndex::STRUCT_NON_BLOCKING
+	};
+
+	const char * const stop = pHaystack + nHaystack;
+	const char * pos = pHaystack;
+	while(pos < stop)
 	{
-		return NextNeedle(needleNr, ret + 1, nHaystack - (ret + 1 - pHaystack));
+		const char * ret = stop;
+		for(size_t needle = 0; needle < FI_NEEDLE_NROF; needle++)
+		{
+			const char * fiNeedle = StructNext(needleTypes[needle], pos, stop);
+			if((nullptr != fiNeedle) && (fiNeedle + strlen(fiNeedles[needle]) <= stop) && (fiNeedle < ret))
+			{
+				ret = fiNeedle;
+				*needleNr = needle;
+			}
+		}
+
+		if(ret == stop)
+		{
+			return nullptr;
+		}
+
+		// Needle inside comment?
+		if(!PosInsideComment(ret))
+		{
+			return ret;
+		}
+
+		pos = ret + 1;
 	}
 
-	return ret;
+	return nullptr;
 }
 
 static bool isSpace(char c)
@@ -370,11 +695,12 @@ static const char * lastNonSpaceGet(const char * in)
 	return out;
 }
 
-static const char * lastCharAfterGet(const char * in, const char * pNeedles, size_t nNeedles)
+// Returns nullptr if none of the needles is found between start and in
+static const char * lastCharAfterGet(const char * in, const char * start, const char * pNeedles, size_t nNeedles)
 {
 	const char * out = in;
 
-	while(*out)
+	while(out >= start)
 	{
 		for(size_t needle = 0; needle < nNeedles; needle++)
 		{
@@ -387,153 +713,50 @@ static const char * lastCharAfterGet(const char * in, const char * pNeedles, siz
 		out--;
 	}
 
-	return out;
+	return nullptr;
 }
 
-// searches before in for type declaration
-RtlFile::signalType_t RtlFile::TypeGet(const char ** declStart, const char * in, const char * inModuleStart)
+// returns <= 0 on error, else signal width
+static int signalWidthGet(const char ** endWidth, const char * in)
 {
-	const char * typeStart[SIGNAL_TYPE_NROF];
-	for(size_t type = 0; type < SIGNAL_TYPE_NROF; type++)
+	if('[' != in[0])
 	{
-		typeStart[type] = strrstr(inModuleStart, in, SignalTypes[type]);
+		nfiError("First char expected to be [\n");
+		return -1;
 	}
 
-	*declStart = inModuleStart;
-	signalType_t ret = SIGNAL_TYPE_NROF;
-	for(size_t type = 0; type < SIGNAL_TYPE_NROF; type++)
+	char * widthColon;
+	long widthHigh = strtol(in + 1, &widthColon, 10);
+	if(in + 1 == widthColon)
 	{
-		if((nullptr != typeStart[type]) && (*declStart < typeStart[type]))
-		{
-			*declStart = typeStart[type];
-			ret = (signalType_t) type;
-		}
+		nfiError("Found no number\n");
+		return -1;
 	}
 
-	// Check if the type declaration belongs to signal
-	if(SIGNAL_TYPE_NROF != ret)
+	if((LONG_MIN == widthHigh) || (LONG_MAX == widthHigh))
 	{
-		const char * illegalSemiColon = strchr(*declStart, ';');
-		if((nullptr != illegalSemiColon) && (illegalSemiColon <= in))
-		{
-			return SIGNAL_TYPE_NROF; // This is not a declaration
-		}
+		nfiError("Width doesn't fit long\n");
+		return -1;
 	}
 
-	return ret;
-}
-
-const char * RtlFile::SignalDeclarationGet(const std::string &signalName, const char * inModuleStart)
-{
-	const char * moduleEnd = strstr(inModuleStart, "endmodule");
-	if(nullptr == moduleEnd)
+	if(':' != *widthColon)
 	{
-		nfiError("Module without endmodule\n");
-		return nullptr;
+		nfiError("Expected colon after width high: %.30s\n", in);
+		return -1;
 	}
 
-	// find end of module input list
-	const char * moduleInputEnd = strchr(inModuleStart, ')');
-
-	if(nullptr == moduleInputEnd)
+	char * widthEnd;
+	long widthLow = strtol(widthColon + 1, &widthEnd, 10);
+	if(widthColon + 1 == widthEnd)
 	{
-		nfiError("Module input list doesn't end\n");
-		return nullptr;
+		nfiError("Found no number\n");
+		return -1;
 	}
 
-	if(moduleInputEnd >= moduleEnd)
+	if((LONG_MIN == widthLow) || (LONG_MAX == widthLow))
 	{
-		nfiError("Module input list doesn't end\n");
-		return nullptr;
-	}
-
-	// Search declaration
-	bool foundDecl = false;
-	const char * signalIoDecl = nullptr;
-	const char * signalDecl = moduleInputEnd;
-	while(signalDecl < moduleEnd)
-	{
-		signalDecl = strstr(signalDecl, signalName.c_str());
-		if(nullptr == signalDecl)
-		{
-			break;
-		}
-
-		if(!PosInsideComment(signalDecl, inModuleStart, moduleEnd))
-		{
-			const char * typeStart;
-			const signalType_t type = TypeGet(&typeStart, signalDecl, inModuleStart);
-			if((SIGNAL_TYPE_INPUT == type) || (SIGNAL_TYPE_OUTPUT == type))
-			{
-				signalIoDecl = typeStart;
-			}
-			else if(SIGNAL_TYPE_NROF != type)
-			{
-				foundDecl = true;
-				signalDecl = typeStart;
-				break;
-			}
-		}
-
-		signalDecl++;
-	}
-
-	if(!foundDecl && (nullptr != signalIoDecl))
-	{
-		signalDecl = signalIoDecl; // e.g. "input [a:b] signal" will default to wire
-	}
-	else if(!foundDecl)
-	{
-		nfiError("Could not find signal declaration\n");
-		return nullptr;
-	}
-
-	nfiDebug("declaration '%.30s' (io decl '%.30s')\n", signalDecl, signalIoDecl != nullptr ? signalIoDecl : "N.A.");
-
-	return signalDecl;
-}
-
-// returns <= 0 on error, else signal width
-static int signalWidthGet(const char ** endWidth, const char * in)
-{
-	if('[' != in[0])
-	{
-		nfiError("First char expected to be [\n");
-		return -1;
-	}
-
-	char * widthColon;
-	long widthHigh = strtol(in + 1, &widthColon, 10);
-	if(in + 1 == widthColon)
-	{
-		nfiError("Found no number\n");
-		return -1;
-	}
-
-	if((LONG_MIN == widthHigh) || (LONG_MAX == widthHigh))
-	{
-		nfiError("Width doesn't fit long\n");
-		return -1;
-	}
-
-	if(':' != *widthColon)
-	{
-		nfiError("Expected colon after width high: %.30s\n", in);
-		return -1;
-	}
-
-	char * widthEnd;
-	long widthLow = strtol(widthColon + 1, &widthEnd, 10);
-	if(widthColon + 1 == widthEnd)
-	{
-		nfiError("Found no number\n");
-		return -1;
-	}
-
-	if((LONG_MIN == widthLow) || (LONG_MAX == widthLow))
-	{
-		nfiError("Width doesn't fit long\n");
-		return -1;
+		nfiError("Width doesn't fit long\n");
+		return -1;
 	}
 
 	if(']' != *widthEnd)
@@ -668,189 +891,118 @@ static int subSignalArraySizeGet(const char ** endArray, const char * in)
 	return abs(widthHigh - widthLow) + 1;
 }
 
-int RtlFile::SignalDeclarationParse(signal_t * signal, const char * declaration)
+static bool isIdentifierChar(char c)
 {
-	// Get Type
-	const char * typeStart[SIGNAL_TYPE_NROF];
-	for(size_t type = 0; type < SIGNAL_TYPE_NROF; type++)
-	{
-		typeStart[type] = strstr(declaration, SignalTypes[type]);
-	}
+	return (('a' <= c) && ('z' >= c)) || (('A' <= c) && ('Z' >= c)) ||
+			(('0' <= c) && ('9' >= c)) || ('_' == c) || ('$' == c);
+}
 
-	signal->Type = SIGNAL_TYPE_NROF;
-	const char * pType = declaration + 1000; // TODO: DIRTY
-	for(size_t type = 0; type < SIGNAL_TYPE_NROF; type++)
+// Escaped identifiers end before white space
+static const char * identifierEndGet(const char * in, const char * stop)
+{
+	const char * out = in;
+	if('\\' == *out)
 	{
-		if((nullptr != typeStart[type]) && (pType > typeStart[type]))
+		while((out < stop) && !isWhiteSpace(*out))
 		{
-			pType = typeStart[type];
-			signal->Type = (signalType_t) type;
+			out++;
 		}
-	}
 
-	if(SIGNAL_TYPE_NROF == signal->Type)
-	{
-		nfiError("Couldn't get signal type\n");
-		return -1;
+		return out;
 	}
 
-	// Get width
-	const char * afterType = typeStart[signal->Type] + strlen(SignalTypes[signal->Type]);
-	afterType = firstNonSpaceGet(afterType);
-	if('[' == *afterType)
+	while((out < stop) && isIdentifierChar(*out))
 	{
-		int width = signalWidthGet(&afterType, afterType);
-		if(0 >= width)
-		{
-			nfiError("signalWidthGet failed: %.30s\n", declaration);
-			return -1;
-		}
+		out++;
+	}
 
-		signal->Width = width;
+	return out;
+}
 
-		afterType++; // after ]
-		afterType = firstNonSpaceGet(afterType);
-	}
-	else
-	{
-		signal->Width = 1;
-	}
+// Returns end of comment / attribute containing pos, or pos itself
+const char * RtlFile::CommentSkip(const char * pos) const
+{
+	Profiler::Count(Profiler::COUNTER_COMMENT_CHECKS);
 
-	// Get Name
-	const char * endNameSemiColon = strchr(afterType, ';');
-	const char * endNameSpace = strchr(afterType, ' ');
+	const size_t offset = pos - Content_;
 
-	const char * endName = nullptr;
-	if((nullptr != endNameSemiColon) && (nullptr != endNameSpace))
-	{
-		endName = (endNameSemiColon < endNameSpace) ? endNameSemiColon : endNameSpace;
-	}
-	else if(nullptr != endNameSemiColon)
+	auto it = std::upper_bound(CommentIndex_.begin(), CommentIndex_.end(), offset,
+			[](size_t off, const std::pair<size_t, size_t> &region) { return off < region.first; });
+	if(CommentIndex_.begin() == it)
 	{
-		endName = endNameSemiColon;
+		return pos;
 	}
-	else if(nullptr != endNameSpace)
-	{
-		endName = endNameSpace;
-	}
-	else
+
+	it--;
+	if(offset < it->second)
 	{
-		nfiError("Name doesn't end\n");
-		return -1;
+		return Content_ + it->second;
 	}
 
-	const size_t nameLen = endName - afterType;
-	std::vector<char> name(nameLen + 1);
-	memcpy(name.data(), afterType, nameLen);
-	name[nameLen] = '\0';
-	signal->Name = name.data();
-
-	const char * afterName = afterType + nameLen;
+	return pos;
+}
 
-	// Get Array Element Count
-	const char * arrayStart = strchr(afterName, '[');
-	if((nullptr != arrayStart) && (arrayStart < endNameSemiColon))
+const char * RtlFile::SpaceSkip(const char * pos, const char * stop) const
+{
+	const char * out = pos;
+	while(out < stop)
 	{
-		const char * tmp;
-		int arraySize = signalArraySizeGet(&tmp, arrayStart);
-		if(0 >= arraySize)
+		const char * afterComment = CommentSkip(out);
+		if(afterComment != out)
 		{
-			nfiError("signalArraySizeGet failed\n");
-			return -1;
+			out = afterComment;
+		}
+		else if(isWhiteSpace(*out))
+		{
+			out++;
+		}
+		else
+		{
+			break;
 		}
-
-		signal->ElemCnt = arraySize;
-	}
-	else
-	{
-		signal->ElemCnt = 1;
 	}
 
-	return 0;
+	return out;
 }
 
-// Returns < 1 on error, else the signal width
-int RtlFile::SubSignalWidthGet(const std::string &inSubSignal, const char * inModuleStart)
+RtlFile::signalType_t RtlFile::KeywordTypeGet(const char * start, const char * end)
 {
-	// Extract signal name
-	const char * widthStart = nullptr;
-	if('\\' != inSubSignal[0])
-	{
-		widthStart = strchr(inSubSignal.c_str(), '[');
-	}
-	else
+	for(size_t type = 0; type < SIGNAL_TYPE_NROF; type++)
 	{
-		widthStart = strstr(inSubSignal.c_str(), " [");
-		if(nullptr != widthStart)
+		if((strlen(SignalTypes[type]) == (size_t) (end - start)) && (0 == strncmp(start, SignalTypes[type], end - start)))
 		{
-			widthStart++; // i.e. point to '['
+			return (signalType_t) type;
 		}
 	}
 
-	if(nullptr == widthStart)
-	{
-		nfiError("Could not find '['\n");
-		return -1;
-	}
-
-	const size_t nameLen = widthStart - inSubSignal.c_str();
-
-	std::vector<char> signalName(nameLen + 1);
-	memcpy(signalName.data(), inSubSignal.c_str(), nameLen);
-	signalName[nameLen] = '\0';
-
-	// Find signal declaration
-	const char * signalDecl = SignalDeclarationGet(signalName.data(), inModuleStart);
-	if(nullptr == signalDecl)
-	{
-		nfiError("SignalDeclarationGet failed\n");
-		return -1;
-	}
-
-	signal_t signal;
-	if(SignalDeclarationParse(&signal, signalDecl))
-	{
-		nfiError("SignalDeclarationParse failed\n");
-		return -1;
-	}
+	return SIGNAL_TYPE_NROF;
+}
 
-	// What width is subsignal
-	const char * tmp;
-	int arraySize = subSignalArraySizeGet(&tmp, widthStart);
-	if(0 >= arraySize)
-	{
-		nfiError("signalArraySizeGet failed\n");
-		return -1;
-	}
+// Block keywords may precede a statement within the same ';' delimited chunk, e.g. "end else"
+static bool blockKeywordIs(const char * start, const char * end)
+{
+	static constexpr const char * blockKeywords[] = {
+			"begin", "end", "else", "endcase", "generate", "endgenerate", "endfunction", "endtask"
+	};
 
-	// TODO: Only supporting single dimensional sub and arrays
-	// Is signal an array?
-	if(1 < signal.ElemCnt)
+	for(const auto &keyword: blockKeywords)
 	{
-		// Assume the sub is an array index
-		if(arraySize > signal.ElemCnt)
+		if((strlen(keyword) == (size_t) (end - start)) && (0 == strncmp(start, keyword, end - start)))
 		{
-			nfiError("subsignal is larger than array declaration\n");
-			return -1;
+			return true;
 		}
-
-		return arraySize * signal.Width;
-	}
-
-	if(arraySize > signal.Width)
-	{
-		nfiError("subsignal is larger than width declaration\n");
-		return -1;
 	}
 
-	return arraySize;
+	return false;
 }
 
-int RtlFile::NeedleCorrupt(
-		fiMode_t fiMode, module_t * module, std::map<const char *, diff_t> * diff,
-		const std::string &fiPrefix, const char * moduleStart, const char * moduleEnd, const char * needle, fiNeedle_t needleNr)
+// Finds target signal, '=' and ';' of the assignment at needle and appends it to Statements_
+int RtlFile::AssignmentStatementCreate(fiNeedle_t needleNr, const char * needle, const char * moduleStart, const char * moduleEnd)
 {
-	nfiDebug("Needle '%.30s'\n", needle);
+	Profiler::Count(Profiler::COUNTER_NEEDLES);
+
+	statement_t statement;
+	statement.Type = (FI_NEEDLE_ASSIGN == needleNr) ? STATEMENT_ASSIGN : STATEMENT_NON_BLOCKING;
 
 	// Find target signal
 	const char * targetSignalStart = nullptr;
@@ -863,7 +1015,7 @@ int RtlFile::NeedleCorrupt(
 	case FI_NEEDLE_ASSIGN_NON_BLOCKIN:
 	{
 		const char * assigneeEnd = lastNonSpaceGet(needle - 1);
-		targetSignalStart = lastCharAfterGet(assigneeEnd, "\n )", 3);
+		targetSignalStart = lastCharAfterGet(assigneeEnd, moduleStart, "\n )", 3);
 	}
 		break;
 
@@ -880,177 +1032,621 @@ int RtlFile::NeedleCorrupt(
 
 	// Remove spaces
 	targetSignalStart = firstNonSpaceGet(targetSignalStart);
-	nfiDebug("Needle expression: %.70s\n", targetSignalStart);
 
 	// Find end of signal name
-	const char * targetSignalEndEqual = nullptr;
-	switch(needleNr)
+	const char * targetSignalEndEqual = rangeFindChar(targetSignalStart, moduleEnd,
+			(FI_NEEDLE_ASSIGN == needleNr) ? '=' : '<');
+	if(nullptr == targetSignalEndEqual)
 	{
-	case FI_NEEDLE_ASSIGN:
-		targetSignalEndEqual = strchr(targetSignalStart, '=');
-		break;
+		nfiError("Couldn't find signal name\n");
+		return -1;
+	}
 
-	case FI_NEEDLE_ASSIGN_NON_BLOCKIN:
-		targetSignalEndEqual = strchr(targetSignalStart, '<');
-		break;
+	// Remove spaces
+	targetSignalEndEqual -= 1; // remove char found above
+	targetSignalEndEqual = lastNonSpaceGet(targetSignalEndEqual);
 
-	// coverity[DEADCODE]
-	default:
-		nfiError("Unknown fiNeedle_t %i\n", needleNr);
+	statement.Start = targetSignalStart;
+	statement.NameEnd = targetSignalEndEqual + 1; // one after last char
+
+	// Corruption is placed between equal sign and semi-colon
+	statement.Equal = rangeFindChar(targetSignalStart, moduleEnd, '=');
+	if(nullptr == statement.Equal)
+	{
+		nfiError("No equal sign in assignment\n");
 		return -1;
 	}
 
-	if((nullptr == targetSignalEndEqual) || (moduleEnd < targetSignalEndEqual))
+	statement.End = StructNext(StructuralIndex::STRUCT_SEMICOLON, targetSignalStart, moduleEnd);
+	if(nullptr == statement.End)
 	{
-		nfiError("Couldn't find signal name\n");
+		nfiError("Needle operation doesn't stop\n");
 		return -1;
 	}
 
-	// Remove spaces
-	targetSignalEndEqual -= 1; // remove char found above
-	targetSignalEndEqual = lastNonSpaceGet(targetSignalEndEqual);
-
-	const char * targetSignalEnd = targetSignalEndEqual + 1; // one after last char
+	Statements_.push_back(statement);
 
-	std::vector<char> targetSignalName(targetSignalEnd - targetSignalStart + 1);
-	memcpy(targetSignalName.data(), targetSignalStart, targetSignalEnd - targetSignalStart);
-	targetSignalName[targetSignalEnd - targetSignalStart] = '\0';
+	return 0;
+}
 
-	// Is it a compound signal? I.e. {signal1, signal2,..}
-	std::vector<std::string> signalNames;
-	if('{' == targetSignalName[0])
+// Appends a declaration or instance statement for the chunk [start, semiColon), if it is one
+void RtlFile::ChunkClassify(const char * start, const char * semiColon)
+{
+	const char * pos = SpaceSkip(start, semiColon);
+	const char * tokenEnd = identifierEndGet(pos, semiColon);
+	while((tokenEnd != pos) && blockKeywordIs(pos, tokenEnd))
 	{
-		// Extract the signals
-		const char * compoundEnd = strchr(targetSignalName.data(), '}');
-		if(nullptr == compoundEnd)
+		pos = SpaceSkip(tokenEnd, semiColon);
+
+		// Named block, e.g. "begin : name"
+		if((pos < semiColon) && (':' == *pos))
 		{
-			nfiError("Compound signal that doesn't end\n");
-			return -1;
+			pos = SpaceSkip(pos + 1, semiColon);
+			pos = SpaceSkip(identifierEndGet(pos, semiColon), semiColon);
 		}
 
-		const char * currSignalStart = targetSignalName.data() + 1;
-		while(currSignalStart < compoundEnd)
-		{
-			currSignalStart = firstNonSpaceGet(currSignalStart);
+		tokenEnd = identifierEndGet(pos, semiColon);
+	}
 
-			const char * nextSignalStart = strchr(currSignalStart, ',');
-			bool lastRound = false;
-			if(nullptr == nextSignalStart)
-			{
-				lastRound = true;
-				nextSignalStart = compoundEnd;
-			}
+	if(tokenEnd == pos)
+	{
+		return;
+	}
 
-			const char * currSignalEnd = nextSignalStart - 1;
+	if(SIGNAL_TYPE_NROF != KeywordTypeGet(pos, tokenEnd))
+	{
+		Statements_.push_back({STATEMENT_DECLARATION, pos, tokenEnd, nullptr, semiColon});
+		return;
+	}
 
-			currSignalEnd = lastNonSpaceGet(currSignalEnd);
+	// Instance: "<module> [#(<parameters>)] <instance> [<range>] (<connections>)"
+	const char * const typeStart = pos;
+	const char * const typeEnd = tokenEnd;
 
-			std::vector<char> tmpBuff(currSignalEnd + 1 - currSignalStart + 1);
-			memcpy(tmpBuff.data(), currSignalStart, currSignalEnd + 1 - currSignalStart);
-			tmpBuff[currSignalEnd + 1 - currSignalStart] = '\0';
+	pos = SpaceSkip(typeEnd, semiColon);
+	if((pos < semiColon) && ('#' == *pos))
+	{
+		pos = SpaceSkip(pos + 1, semiColon);
+		if((pos >= semiColon) || ('(' != *pos))
+		{
+			return;
+		}
 
-			signalNames.push_back(tmpBuff.data());
+		size_t depth = 0;
+		do {
+			const char * afterComment = CommentSkip(pos);
+			if(afterComment != pos)
+			{
+				pos = afterComment;
+				continue;
+			}
 
-			if(!lastRound)
+			if('(' == *pos)
 			{
-				currSignalStart = nextSignalStart + 1; // one after ','
+				depth++;
 			}
-			else
+			else if(')' == *pos)
 			{
-				break;
+				depth--;
 			}
-		}
+			pos++;
+		} while((pos < semiColon) && (0 != depth));
+
+		pos = SpaceSkip(pos, semiColon);
 	}
-	else
+
+	const char * instNameEnd = identifierEndGet(pos, semiColon);
+	if(instNameEnd == pos)
 	{
-		signalNames.push_back(targetSignalName.data());
+		return;
 	}
 
-	// Get required signal width
-	int compoundSignalWidth = 0;
-
-	for(size_t sigIndex = 0; sigIndex < signalNames.size(); sigIndex++)
+	pos = SpaceSkip(instNameEnd, semiColon);
+	if((pos < semiColon) && ('[' == *pos))
 	{
-		if(200 < signalNames[sigIndex].size())
+		const char * rangeEnd = rangeFindChar(pos, semiColon, ']');
+		if(nullptr == rangeEnd)
 		{
-			nfiError("signalName longer than 200 chars: %.200s\n", signalNames[sigIndex].c_str());
-			return -1;
+			return;
 		}
+		pos = SpaceSkip(rangeEnd + 1, semiColon);
+	}
 
-		nfiDebug("targetSignal '%s'\n", signalNames[sigIndex].c_str());
+	if((pos >= semiColon) || ('(' != *pos) || (')' != *(semiColon - 1)))
+	{
+		return;
+	}
 
-		int fiSignalWidth;
+	Statements_.push_back({STATEMENT_INSTANCE, typeStart, typeEnd, nullptr, semiColon});
+}
 
-		// Subsignal?
-		// TODO: Subsignal with escape name?!?
-		// if signal identifier starts with escape character, '[' is allowed as part of name.
-		// In that case, an actual subsignal '[' will be separated by a space
-		const char * targetSignalEndBracket = nullptr;
-		if('\\' != signalNames[sigIndex][0])
+// Single pass over the module splitting it into port list, declarations, assignments and instances
+int RtlFile::ModuleStatementsCreate(moduleIndex_t &entry)
+{
+	const char * const moduleStart = Content_ + entry.Start;
+	const char * const moduleEnd = Content_ + entry.End;
+	const char * const ioEnd = Content_ + entry.PortListEnd;
+
+	const size_t firstStatement = Statements_.size();
+	Statements_.push_back({STATEMENT_PORT_LIST, moduleStart, ioEnd, nullptr, ioEnd + 1});
+
+	size_t needleNr;
+	const char * needle = NextNeedle(&needleNr, moduleStart, moduleEnd - moduleStart);
+
+	const char * chunkStart = ioEnd + 2; // after ");"
+	const char * semiColon = StructNext(StructuralIndex::STRUCT_SEMICOLON, chunkStart, moduleEnd);
+	while(nullptr != needle || nullptr != semiColon)
+	{
+		if((nullptr != semiColon) && PosInsideComment(semiColon))
 		{
-			targetSignalEndBracket = strchr(signalNames[sigIndex].c_str(), '[');
+			semiColon = StructNext(StructuralIndex::STRUCT_SEMICOLON, semiColon + 1, moduleEnd);
+			continue;
 		}
-		else
+
+		if(nullptr != semiColon)
 		{
-			targetSignalEndBracket = strstr(signalNames[sigIndex].c_str(), " [");
+			ChunkClassify(chunkStart, semiColon);
 		}
 
-		if(nullptr != targetSignalEndBracket)
+		// Assignments ending with this chunk
+		while((nullptr != needle) && ((nullptr == semiColon) || (needle < semiColon)))
 		{
-			fiSignalWidth = SubSignalWidthGet(signalNames[sigIndex].c_str(), moduleStart);
-			if(0 >= fiSignalWidth)
+			if(AssignmentStatementCreate((fiNeedle_t) needleNr, needle, moduleStart, moduleEnd))
 			{
-				nfiError("SubSignalWidthGet failed\n");
+				nfiError("AssignmentStatementCreate failed: %.30s\n", needle);
 				return -1;
 			}
+
+			needle = NextNeedle(&needleNr, needle + 1, moduleEnd - (needle + 1));
 		}
-		else
+
+		if(nullptr == semiColon)
 		{
-			// Find signal declaration
-			const char * signalDecl = SignalDeclarationGet(signalNames[sigIndex].c_str(), moduleStart);
-			if(nullptr == signalDecl)
-			{
-				nfiError("SignalDeclarationGet failed\n");
-				return -1;
-			}
+			break;
+		}
 
-			signal_t signal;
-			if(SignalDeclarationParse(&signal, signalDecl))
-			{
-				nfiError("SignalDeclarationParse failed\n");
-				return -1;
-			}
+		chunkStart = semiColon + 1;
+		semiColon = StructNext(StructuralIndex::STRUCT_SEMICOLON, chunkStart, moduleEnd);
+	}
 
-			fiSignalWidth = signal.ElemCnt * signal.Width;
-		}
+	entry.AssignmentsCnt = std::count_if(Statements_.begin() + firstStatement, Statements_.end(),
+			[](const statement_t &statement) {
+				return (STATEMENT_ASSIGN == statement.Type) || (STATEMENT_NON_BLOCKING == statement.Type);
+			});
 
-		compoundSignalWidth += fiSignalWidth;
+	return 0;
+}
 
-		nfiDebug("fiSignalWidth = %i\n", fiSignalWidth);
-	}
+int RtlFile::StatementsCreate(Profiler * profiler)
+{
+	// All modules share one arena, sized for the worst case up front
+	Statements_.clear();
+	Statements_.reserve(ModuleIndex_.size() +
+			Structure_.Positions(StructuralIndex::STRUCT_SEMICOLON).size() +
+			Structure_.Positions(StructuralIndex::STRUCT_ASSIGN).size() +
+			Structure_.Positions(StructuralIndex::STRUCT_NON_BLOCKING).size());
 
-	if(1 < signalNames.size())
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
 	{
-		nfiDebug("compoundSignalWidth = %i\n", compoundSignalWidth);
-	}
+		moduleIndex_t &entry = ModuleIndex_[index];
+		entry.StatementsStart = Statements_.size();
 
-	// Corrupt
-	// Place corruption between equal sign and before semi-colon
-	const char * equal = strchr(targetSignalStart, '=');
-	if(nullptr == equal)
+		Profiler::Scope scope(profiler, Profiler::CategoryModule, entry.Name);
+
+		// Cached modules aren't parsed, only their port list is needed
+		if(nullptr != Cached_[index])
+		{
+			const char * const ioEnd = Content_ + entry.PortListEnd;
+			Statements_.push_back({STATEMENT_PORT_LIST, Content_ + entry.Start, ioEnd, nullptr, ioEnd + 1});
+			entry.StatementsCnt = 1;
+			entry.AssignmentsCnt = Cached_[index]->Sites.size();
+			continue;
+		}
+
+		if(ModuleStatementsCreate(entry))
+		{
+			nfiError("ModuleStatementsCreate failed for module %s (line %lu)\n", entry.Name.c_str(), entry.Line);
+			return -1;
+		}
+
+		entry.StatementsCnt = Statements_.size() - entry.StatementsStart;
+	}
+
+	nfiDebug("%lu statements in %lu modules\n", Statements_.size(), ModuleIndex_.size());
+
+	return 0;
+}
+
+// Parses one declaration statement after its type keyword, e.g. " [3:0] a, b [0:7];"
+// Returns position after the statement or nullptr on error
+const char * RtlFile::DeclarationParse(declarations_t * declarations, signalType_t type, const char * pos, const char * stop) const
+{
+	pos = SpaceSkip(pos, stop);
+
+	// e.g. "output reg", the net type is the more specific one
+	const char * tokenEnd = identifierEndGet(pos, stop);
+	const signalType_t netType = KeywordTypeGet(pos, tokenEnd);
+	if((SIGNAL_TYPE_WIRE == netType) || (SIGNAL_TYPE_REG == netType))
 	{
-		nfiError("No equal sign in assignment\n");
+		type = netType;
+		pos = SpaceSkip(tokenEnd, stop);
+		tokenEnd = identifierEndGet(pos, stop);
+	}
+
+	if((sizeof("signed") - 1 == tokenEnd - pos) && (0 == strncmp(pos, "signed", tokenEnd - pos)))
+	{
+		pos = SpaceSkip(tokenEnd, stop);
+	}
+
+	declaration_t declaration;
+	declaration.Type = type;
+	declaration.Width = 1;
+	declaration.ElemCnt = 1;
+
+	if((pos < stop) && ('[' == *pos))
+	{
+		const char * endWidth;
+		const int width = signalWidthGet(&endWidth, pos);
+		if(0 >= width)
+		{
+			nfiError("signalWidthGet failed: %.30s\n", pos);
+			return nullptr;
+		}
+
+		declaration.Width = width;
+		pos = SpaceSkip(endWidth + 1, stop);
+	}
+
+	// One or more names
+	while(pos < stop)
+	{
+		const char * nameEnd = identifierEndGet(pos, stop);
+		if(nameEnd == pos)
+		{
+			nfiError("Declaration without name: %.30s\n", pos);
+			return nullptr;
+		}
+
+		const std::string_view name = NetNameNormalize(std::string_view(pos, nameEnd - pos));
+		pos = SpaceSkip(nameEnd, stop);
+
+		declaration.ElemCnt = 1;
+		if((pos < stop) && ('[' == *pos))
+		{
+			const char * endArray;
+			const int arraySize = signalArraySizeGet(&endArray, pos);
+			if(0 >= arraySize)
+			{
+				nfiError("signalArraySizeGet failed\n");
+				return nullptr;
+			}
+
+			declaration.ElemCnt = arraySize;
+			pos = SpaceSkip(endArray + 1, stop);
+		}
+
+		// Skip initializer, e.g. "reg a = 1'h0"
+		if((pos < stop) && ('=' == *pos))
+		{
+			size_t depth = 0;
+			while((pos < stop) && (0 != depth || ((',' != *pos) && (';' != *pos))))
+			{
+				if(('(' == *pos) || ('{' == *pos))
+				{
+					depth++;
+				}
+				else if(((')' == *pos) || ('}' == *pos)) && (0 != depth))
+				{
+					depth--;
+				}
+				pos++;
+			}
+		}
+
+		// Declarations of wire / reg win over input / output
+		auto declIt = declarations->find(name);
+		if(declarations->end() == declIt)
+		{
+			(*declarations)[name] = declaration;
+		}
+		else if(((SIGNAL_TYPE_INPUT == declIt->second.Type) || (SIGNAL_TYPE_OUTPUT == declIt->second.Type)) &&
+				((SIGNAL_TYPE_WIRE == declaration.Type) || (SIGNAL_TYPE_REG == declaration.Type)))
+		{
+			declIt->second = declaration;
+		}
+
+		if((pos >= stop) || (',' != *pos))
+		{
+			break; // ';' or end of ANSI port list
+		}
+
+		pos = SpaceSkip(pos + 1, stop);
+
+		// ANSI port list: next declaration follows the comma
+		tokenEnd = identifierEndGet(pos, stop);
+		if(SIGNAL_TYPE_NROF != KeywordTypeGet(pos, tokenEnd))
+		{
+			break;
+		}
+	}
+
+	return pos;
+}
+
+// Collects all declarations of the module from its statements
+int RtlFile::DeclarationsCreate(declarations_t * declarations, const moduleIndex_t &entry) const
+{
+	declarations->clear();
+
+	const statement_t * const statements = Statements_.data() + entry.StatementsStart;
+
+	// ANSI port lists declare inside the port list
+	const char * pos = statements[0].Start;
+	const char * const stop = statements[0].End;
+	while(pos < stop)
+	{
+		const char * afterComment = CommentSkip(pos);
+		if(afterComment != pos)
+		{
+			pos = afterComment;
+			continue;
+		}
+
+		if('"' == *pos)
+		{
+			pos++;
+			while((pos < stop) && ('"' != *pos))
+			{
+				pos += ('\\' == *pos) ? 2 : 1;
+			}
+			pos++;
+			continue;
+		}
+
+		if(('\\' != *pos) && !isIdentifierChar(*pos))
+		{
+			pos++;
+			continue;
+		}
+
+		const char * tokenEnd = identifierEndGet(pos, stop);
+		const signalType_t type = KeywordTypeGet(pos, tokenEnd);
+		if(SIGNAL_TYPE_NROF == type)
+		{
+			pos = (tokenEnd == pos) ? pos + 1 : tokenEnd;
+			continue;
+		}
+
+		pos = DeclarationParse(declarations, type, tokenEnd, stop);
+		if(nullptr == pos)
+		{
+			nfiError("DeclarationParse failed\n");
+			return -1;
+		}
+	}
+
+	for(size_t nr = 1; nr < entry.StatementsCnt; nr++)
+	{
+		const statement_t &statement = statements[nr];
+		if(STATEMENT_DECLARATION != statement.Type)
+		{
+			continue;
+		}
+
+		if(nullptr == DeclarationParse(declarations, KeywordTypeGet(statement.Start, statement.NameEnd),
+				statement.NameEnd, statement.End))
+		{
+			nfiError("DeclarationParse failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Returns where the select of signal starts, e.g. "a[3:0]", or nullptr if there is none
+// If signal identifier starts with escape character, '[' is allowed as part of name.
+// In that case, an actual subsignal '[' will be separated by a space
+static const char * signalSelectFind(std::string_view signal)
+{
+	const size_t pos = ('\\' != signal[0]) ? signal.find('[') : signal.find(" [");
+	if(std::string_view::npos == pos)
+	{
+		return nullptr;
+	}
+
+	return signal.data() + pos + (('\\' != signal[0]) ? 0 : 1); // i.e. point to '['
+}
+
+// Calls func(signal) for each signal of an assignment target, i.e. the target itself or each part of "{a, b}"
+// Returns -1 if the target is malformed or func returns non-zero
+template<typename func_t>
+static int targetSignalsForEach(std::string_view target, const func_t &func)
+{
+	if('{' != target[0])
+	{
+		return func(target) ? -1 : 0;
+	}
+
+	// Extract the signals
+	const char * const compoundEnd = (const char *) memchr(target.data(), '}', target.size());
+	if(nullptr == compoundEnd)
+	{
+		nfiError("Compound signal that doesn't end\n");
 		return -1;
 	}
 
-	const char * semiColon = strchr(targetSignalStart, ';');
-	if(nullptr == semiColon)
+	const char * currSignalStart = target.data() + 1;
+	while(currSignalStart < compoundEnd)
 	{
-		nfiError("Needle operation doesn't stop\n");
+		currSignalStart = firstNonSpaceGet(currSignalStart);
+
+		const char * nextSignalStart = (const char *) memchr(currSignalStart, ',', compoundEnd - currSignalStart);
+		const bool lastRound = (nullptr == nextSignalStart);
+		if(lastRound)
+		{
+			nextSignalStart = compoundEnd;
+		}
+
+		const char * const currSignalEnd = lastNonSpaceGet(nextSignalStart - 1);
+
+		if(func(std::string_view(currSignalStart, currSignalEnd + 1 - currSignalStart)))
+		{
+			return -1;
+		}
+
+		if(lastRound)
+		{
+			break;
+		}
+
+		currSignalStart = nextSignalStart + 1; // one after ','
+	}
+
+	return 0;
+}
+
+// Name of the fault site of an assignment to target as stored in the cache, e.g. "fi_ab" for "{a, b}"
+static void fiNameGet(std::string * name, std::string_view target)
+{
+	*name = "fi_";
+	targetSignalsForEach(target, [&](std::string_view signal) {
+		name->append(signal);
+		return 0;
+	});
+}
+
+// Returns < 1 on error, else the signal width
+int RtlFile::SubSignalWidthGet(std::string_view inSubSignal, const declarations_t &declarations)
+{
+	// Extract signal name
+	const char * widthStart = signalSelectFind(inSubSignal);
+	if(nullptr == widthStart)
+	{
+		nfiError("Could not find '['\n");
+		return -1;
+	}
+
+	// Find signal declaration
+	const std::string_view signalName(inSubSignal.data(), lastNonSpaceGet(widthStart - 1) + 1 - inSubSignal.data());
+	Profiler::Count(Profiler::COUNTER_DECLARATION_LOOKUPS);
+	const auto declIt = declarations.find(NetNameNormalize(signalName));
+	if(declarations.end() == declIt)
+	{
+		nfiError("Could not find signal declaration of %.*s\n", (int) signalName.size(), signalName.data());
+		return -1;
+	}
+
+	const declaration_t &signal = declIt->second;
+
+	// What width is subsignal
+	const char * tmp;
+	int arraySize = subSignalArraySizeGet(&tmp, widthStart);
+	if(0 >= arraySize)
+	{
+		nfiError("signalArraySizeGet failed\n");
+		return -1;
+	}
+
+	// TODO: Only supporting single dimensional sub and arrays
+	// Is signal an array?
+	if(1 < signal.ElemCnt)
+	{
+		// Assume the sub is an array index
+		if(arraySize > signal.ElemCnt)
+		{
+			nfiError("subsignal is larger than array declaration\n");
+			return -1;
+		}
+
+		return arraySize * signal.Width;
+	}
+
+	if(arraySize > signal.Width)
+	{
+		nfiError("subsignal is larger than width declaration\n");
 		return -1;
 	}
 
-	const char * newLine = strchr(targetSignalStart, '\n');
+	return arraySize;
+}
+
+// Works on spans of Content_ only, nothing is allocated per assignment
+int RtlFile::NeedleCorrupt(
+		fiMode_t fiMode, module_t * module, diffList_t * diff,
+		const std::string &fiPrefix, const declarations_t &declarations, const statement_t &statement, size_t uuid) const
+{
+	const char * const targetSignalStart = statement.Start;
+	const std::string_view target(targetSignalStart, statement.NameEnd - targetSignalStart);
+
+	nfiDebug("Needle expression: %.70s\n", targetSignalStart);
+
+	// Get required signal width, i.e. the sum of all signals of a compound target
+	int compoundSignalWidth = 0;
+	size_t signalsCnt = 0;
+
+	const int ret = targetSignalsForEach(target, [&](std::string_view signalName) {
+		if(200 < signalName.size())
+		{
+			nfiError("signalName longer than 200 chars: %.200s\n", signalName.data());
+			return -1;
+		}
+
+		nfiDebug("targetSignal '%.*s'\n", (int) signalName.size(), signalName.data());
+
+		int fiSignalWidth;
+
+		// Subsignal?
+		// TODO: Subsignal with escape name?!?
+		if(nullptr != signalSelectFind(signalName))
+		{
+			fiSignalWidth = SubSignalWidthGet(signalName, declarations);
+			if(0 >= fiSignalWidth)
+			{
+				nfiError("SubSignalWidthGet failed\n");
+				return -1;
+			}
+		}
+		else
+		{
+			Profiler::Count(Profiler::COUNTER_DECLARATION_LOOKUPS);
+			const auto declIt = declarations.find(NetNameNormalize(signalName));
+			if(declarations.end() == declIt)
+			{
+				nfiError("Could not find signal declaration of %.*s\n", (int) signalName.size(), signalName.data());
+				return -1;
+			}
+
+			const declaration_t &signal = declIt->second;
+
+			fiSignalWidth = signal.ElemCnt * signal.Width;
+		}
+
+		compoundSignalWidth += fiSignalWidth;
+		signalsCnt++;
+
+		nfiDebug("fiSignalWidth = %i\n", fiSignalWidth);
+
+		return 0;
+	});
+
+	if(ret)
+	{
+		nfiError("Getting width of %.*s failed\n", (int) target.size(), target.data());
+		return -1;
+	}
+
+	if(1 < signalsCnt)
+	{
+		nfiDebug("compoundSignalWidth = %i\n", compoundSignalWidth);
+	}
+
+	// Corrupt
+	// Place corruption between equal sign and before semi-colon
+	const char * equal = statement.Equal;
+	const char * const semiColon = statement.End;
+
+	const char * newLine = StructNext(StructuralIndex::STRUCT_NEWLINE, targetSignalStart, Content_ + Size_);
 	if(nullptr == newLine)
 	{
 		nfiError("No new line after needle operation\n");
@@ -1069,7 +1665,7 @@ int RtlFile::NeedleCorrupt(
 		return -1;
 	}
 
-	if(PosInsideComment(equal, moduleStart, semiColon))
+	if(PosInsideComment(equal))
 	{
 		nfiError("Equal sign within comment\n");
 		return -1;
@@ -1082,459 +1678,1013 @@ int RtlFile::NeedleCorrupt(
 	fiSignal.Type = SIGNAL_TYPE_WIRE;
 	fiSignal.Width = compoundSignalWidth;
 	fiSignal.ElemCnt = 1;
-
-	fiSignal.Name = "fi_";
-	for(const auto &name: signalNames)
-	{
-		fiSignal.Name += name;
-	}
-
-	fiSignal.UUID = uuidGet();
+	fiSignal.Target = target;
+	fiSignal.UUID = uuid;
+	fiSignal.SiteStart = equal - Content_;
+	fiSignal.SiteEnd = semiColon - Content_;
 
 	module->FiSignal.push_back(fiSignal);
 
-	if(diff->end() != diff->find(equal))
+	if((nullptr != diff) && CorruptionRender(diff, fiMode, fiPrefix, fiSignal, equal, semiColon))
 	{
-		nfiError("Diff already created\n");
+		nfiError("CorruptionRender failed\n");
 		return -1;
 	}
 
-	diff_t &diffElem = (*diff)[equal];
-	diffElem.End = semiColon;
+	nfiDebug("\n\n\n");
 
-	// Original assignment
-	std::vector<char> originalAssignment(semiColon - equal + 1);
-	memcpy(originalAssignment.data(), equal, semiColon - equal);
-	originalAssignment[semiColon - equal] = '\0';
+	return 0;
+}
 
-	nfiDebug("orig. Ass: '%s'\n", originalAssignment.data());
+// Replaces the expression [equal, semiColon) by its corrupted version
+int RtlFile::CorruptionRender(diffList_t * diff, fiMode_t fiMode, const std::string &fiPrefix, const signal_t &fiSignal,
+		const char * equal, const char * semiColon)
+{
+	TextArena &text = diff->Text;
 
-	diffElem.Replacement = "(";
-	diffElem.Replacement += originalAssignment.data();
-	diffElem.Replacement += ")";
+	nfiDebug("orig. Ass: '%.*s'\n", (int) (semiColon - equal), equal);
+
+	// Original assignment
+	text.Append("(");
+	text.Append(equal, semiColon - equal);
+	text.Append(")");
 
 	switch(fiMode)
 	{
 	case FI_MODE_STUCK_HIGH:
-		diffElem.Replacement += " | ";
+		text.Append(" | ");
 		break;
 
 	case FI_MODE_STUCK_LOW:
-		diffElem.Replacement += " & ~";
+		text.Append(" & ~");
 		break;
 
 	case FI_MODE_FLIP:
-		diffElem.Replacement += " ^ ";
+		text.Append(" ^ ");
 		break;
 
 	default:
 		nfiError("Unknown fiMode\n");
+		text.Finish();
+		return -1;
+	}
+
+	text.Append("((");
+	text.Append(FiEnableStr);
+	text.Append(" && (");
+	text.AppendNumber(fiSignal.UUID);
+	text.Append(" == ");
+	text.Append(fiPrefix);
+	text.Append(GlobalFiNumber_);
+	text.Append(")) ? ");
+#if FI_SINGLE_BIT
+	text.Append("(");
+	text.AppendNumber(fiSignal.Width);
+	text.Append("'d1 << ");
+	text.Append(fiPrefix);
+	text.Append(GlobalFiSignal_);
+	text.Append(")");
+#else // !FI_SINGLE_BIT
+	text.Append(fiPrefix);
+	text.Append(GlobalFiSignal_);
+	if(1 == fiSignal.Width)
+	{
+		text.Append("[0]");
+	}
+	else
+	{
+		text.Append("[");
+		text.AppendNumber(fiSignal.Width - 1);
+		text.Append(":0]");
+	}
+#endif // !FI_SINGLE_BIT
+
+	text.Append(" : {");
+	text.AppendNumber(fiSignal.Width);
+	text.Append("{1'b0}})");
+
+	const std::string_view replacement = text.Finish();
+	diff->Edits.push_back({equal, semiColon, replacement});
+
+	nfiDebug("Replacement: '%.*s'\n", (int) replacement.size(), replacement.data());
+
+	return 0;
+}
+
+int RtlFile::FiEnableInputAdd(diffList_t * diff, const statement_t &portList)
+{
+	const char * ioEnd = portList.End - 1;
+	const char * replaceStart = ioEnd; // before );
+
+	TextArena &text = diff->Text;
+	text.Append(", ");
+	text.Append(FiEnableStr);
+	text.Append(");\n input ");
+	text.Append(FiEnableStr);
+	text.Append(";\n wire ");
+	text.Append(FiEnableStr);
+	text.Append(";");
+
+	diff->Edits.push_back({replaceStart, ioEnd + 2, text.Finish()}); // up to after ");"
+
+	return 0;
+}
+
+int RtlFile::ModuleFi(
+		bool isTop, const std::string &fiPrefix,
+		fiMode_t fiMode,
+		module_t * module, diffList_t * diff,
+		const moduleIndex_t &entry, size_t uuidBase) const
+{
+	const statement_t * const statements = Statements_.data() + entry.StatementsStart;
+
+	// Add Fi enable wire to inputs
+	if(!isTop && (nullptr != diff))
+	{
+		if(FiEnableInputAdd(diff, statements[0]))
+		{
+			nfiError("FiEnableInputAdd failed\n");
+			return -1;
+		}
+	}
+
+	// Widths of all signals in this module, exact ones from Yosys' JSON if it has the module
+	const declarations_t * declarations = (nullptr != Json_) ? Json_->Declarations(entry.Name) : nullptr;
+	declarations_t parsed;
+	if(nullptr == declarations)
+	{
+		if(DeclarationsCreate(&parsed, entry))
+		{
+			nfiError("DeclarationsCreate failed\n");
+			return -1;
+		}
+
+		declarations = &parsed;
+	}
+
+	// Everything the assignments need is allocated up front, the loop below doesn't allocate
+	module->FiSignal.reserve(module->FiSignal.size() + entry.AssignmentsCnt);
+	if(nullptr != diff)
+	{
+		diff->Edits.reserve(diff->Edits.size() + entry.AssignmentsCnt);
+
+		size_t textSize = 0;
+		for(size_t nr = 0; nr < entry.StatementsCnt; nr++)
+		{
+			const statement_t &statement = statements[nr];
+			if((STATEMENT_ASSIGN == statement.Type) || (STATEMENT_NON_BLOCKING == statement.Type))
+			{
+				textSize += (statement.End - statement.Equal) + 2 * fiPrefix.size() + CorruptionOverhead_;
+			}
+		}
+
+		diff->Text.Reserve(textSize);
+	}
+
+#if NFI_DEBUG
+	const size_t allocCnt = nfiAllocCnt;
+#endif // NFI_DEBUG
+
+	// Add corruption to all assignments, their UUIDs follow uuidBase in text order
+	size_t uuid = uuidBase;
+	for(size_t nr = 0; nr < entry.StatementsCnt; nr++)
+	{
+		const statement_t &statement = statements[nr];
+		if((STATEMENT_ASSIGN != statement.Type) && (STATEMENT_NON_BLOCKING != statement.Type))
+		{
+			continue;
+		}
+
+		if(NeedleCorrupt(fiMode, module, diff, fiPrefix, *declarations, statement, uuid++))
+		{
+			nfiError("NeedleCorrupt failed\n");
+			if(&parsed != declarations)
+			{
+				nfiError("Nets of %s taken from %s, was the Verilog written with write_verilog -norename?\n",
+						entry.Name.c_str(), Json_->Name().c_str());
+			}
+			return -1;
+		}
+	}
+
+	nfiDebug("%lu allocations for %lu assignments of %s\n", nfiAllocCnt - allocCnt, uuid - uuidBase, entry.Name.c_str());
+
+	return 0;
+}
+
+// Renders the fault sites of an unchanged module from the cache, nothing is parsed
+int RtlFile::ModuleFiCached(
+		bool isTop, const std::string &fiPrefix,
+		fiMode_t fiMode,
+		module_t * module, diffList_t * diff,
+		const moduleIndex_t &entry, const FiCache::entry_t &cached) const
+{
+	if(!isTop)
+	{
+		if(FiEnableInputAdd(diff, Statements_[entry.StatementsStart]))
+		{
+			nfiError("FiEnableInputAdd failed\n");
+			return -1;
+		}
+	}
+
+	for(const auto &site: cached.Sites)
+	{
+		if((site.End < site.Start) || (entry.End - entry.Start <= site.End))
+		{
+			nfiError("Cached fault site outside of module\n");
+			return -1;
+		}
+
+		signal_t fiSignal;
+		fiSignal.Type = SIGNAL_TYPE_WIRE;
+		fiSignal.Width = site.Width;
+		fiSignal.ElemCnt = 1;
+		fiSignal.UUID = site.UUID;
+		fiSignal.SiteStart = entry.Start + site.Start;
+		fiSignal.SiteEnd = entry.Start + site.End;
+
+		module->FiSignal.push_back(fiSignal);
+
+		const char * const equal = Content_ + fiSignal.SiteStart;
+		if(CorruptionRender(diff, fiMode, fiPrefix, fiSignal, equal, Content_ + fiSignal.SiteEnd))
+		{
+			nfiError("CorruptionRender failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Instruments module index entry index, from the cache if possible
+int RtlFile::ModuleFiRun(size_t index, fiMode_t fiMode, module_t * module, size_t uuidBase, diffList_t * diff) const
+{
+	const moduleIndex_t &entry = ModuleIndex_[index];
+
+	nfiDebug("Insert FI in %s\n", entry.Name.c_str());
+
+	const bool moduleIsTop = (entry.Name == TopModule_);
+
+	const std::string fiPrefix = moduleIsTop ? "" : TopModule_ + ".";
+
+	const int ret = (nullptr != Cached_[index]) ?
+			ModuleFiCached(moduleIsTop, fiPrefix, fiMode, module, diff, entry, *Cached_[index]) :
+			ModuleFi(moduleIsTop, fiPrefix, fiMode, module, diff, entry, uuidBase);
+	if(ret)
+	{
+		nfiError("moduleFi failed for module %s (line %lu) in %s\n", entry.Name.c_str(), entry.Line, Name_.c_str());
 		return -1;
 	}
 
-	diffElem.Replacement += "((" + std::string(FiEnableStr);
-	diffElem.Replacement += " && (" + std::to_string(fiSignal.UUID) + " == " + fiPrefix + GlobalFiNumber_ + ")) ? ";
-#if FI_SINGLE_BIT
-	diffElem.Replacement += "(" + std::to_string(fiSignal.Width) + "'d1 << " + fiPrefix + GlobalFiSignal_ + ")";
-#else // !FI_SINGLE_BIT
-	diffElem.Replacement += fiPrefix + GlobalFiSignal_;
-	if(1 == fiSignal.Width)
+	return 0;
+}
+
+bool RtlFile::BodyEqual(size_t index, const RtlFile &other, size_t otherIndex) const
+{
+	const moduleIndex_t &entry = ModuleIndex_[index];
+	const moduleIndex_t &otherEntry = other.ModuleIndex_[otherIndex];
+	const size_t size = entry.End - entry.Start;
+
+	return (size == otherEntry.End - otherEntry.Start) &&
+			(0 == memcmp(Content_ + entry.Start, other.Content_ + otherEntry.Start, size));
+}
+
+// Instruments module index like the module of replay, which has the same body
+int RtlFile::ModuleFiReplay(size_t index, fiMode_t fiMode, module_t * module, size_t uuidBase, diffList_t * diff, const replay_t &replay) const
+{
+	const moduleIndex_t &entry = ModuleIndex_[index];
+	const char * const body = Content_ + entry.Start;
+	const bool moduleIsTop = (entry.Name == TopModule_);
+	const std::string fiPrefix = moduleIsTop ? "" : TopModule_ + ".";
+
+	nfiDebug("Replay FI in %s\n", entry.Name.c_str());
+
+	if(!moduleIsTop && FiEnableInputAdd(diff, Statements_[entry.StatementsStart]))
+	{
+		nfiError("FiEnableInputAdd failed\n");
+		return -1;
+	}
+
+	const char * const replayBody = replay.Content + replay.Start;
+
+	module->FiSignal.reserve(module->FiSignal.size() + replay.Module->FiSignal.size());
+	diff->Edits.reserve(diff->Edits.size() + replay.Module->FiSignal.size());
+
+	for(const auto &replayed: replay.Module->FiSignal)
+	{
+		signal_t fiSignal = replayed;
+		fiSignal.UUID = uuidBase + (replayed.UUID - replay.UuidBase);
+		fiSignal.SiteStart = entry.Start + (replayed.SiteStart - replay.Start);
+		fiSignal.SiteEnd = entry.Start + (replayed.SiteEnd - replay.Start);
+		fiSignal.Target = std::string_view(body + (replayed.Target.data() - replayBody), replayed.Target.size());
+
+		module->FiSignal.push_back(fiSignal);
+
+		if(CorruptionRender(diff, fiMode, fiPrefix, fiSignal, Content_ + fiSignal.SiteStart, Content_ + fiSignal.SiteEnd))
+		{
+			nfiError("CorruptionRender failed for module %s (line %lu) in %s\n", entry.Name.c_str(), entry.Line, Name_.c_str());
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+ptrdiff_t RtlFile::DiffGrowthGet(const diffList_t &diff)
+{
+	ptrdiff_t growth = diff.Text.Size();
+	for(const auto &edit: diff.Edits)
+	{
+		growth -= edit.End - edit.Start;
+	}
+
+	return growth;
+}
+
+int RtlFile::DiffApply(diffList_t &diff)
+{
+	std::vector<diff_t> &edits = diff.Edits;
+
+	// Edits are mostly appended in text order already
+	if(!std::is_sorted(edits.begin(), edits.end(), [](const diff_t &a, const diff_t &b) { return a.Start < b.Start; }))
+	{
+		std::sort(edits.begin(), edits.end(), [](const diff_t &a, const diff_t &b) { return a.Start < b.Start; });
+	}
+
+	// check that there is no overlapping diff
+	for(size_t nr = 0; nr < edits.size(); nr++)
+	{
+		if(edits[nr].Start > edits[nr].End)
+		{
+			nfiError("Diff end before beginning\n");
+			return -1;
+		}
+
+		if((0 < nr) && (edits[nr].Start <= edits[nr - 1].End))
+		{
+			nfiError("Overlapping diff\n");
+			return -1;
+		}
+	}
+
+	if(edits.empty())
+	{
+		return 0; // keeps files without edits unedited
+	}
+
+	// Diffs refer to the original content, earlier rounds are already in the pieces
+	if(Pieces_.empty())
+	{
+		Pieces_.push_back({Content_, Size_, true});
+	}
+
+	std::vector<piece_t> pieces;
+	pieces.reserve(Pieces_.size() + 2 * edits.size());
+
+	auto diffIt = edits.begin();
+	for(size_t pieceNr = 0; pieceNr < Pieces_.size(); pieceNr++)
+	{
+		const piece_t &piece = Pieces_[pieceNr];
+		if(!piece.Original)
+		{
+			pieces.push_back(piece);
+			continue;
+		}
+
+		const char * pos = piece.Start;
+		const char * const pieceEnd = piece.Start + piece.Size;
+
+		// Insertions at the end of this piece go here, unless the next piece continues the original
+		const bool nextContinues = (pieceNr + 1 < Pieces_.size()) &&
+				Pieces_[pieceNr + 1].Original && (Pieces_[pieceNr + 1].Start == pieceEnd);
+
+		while((edits.end() != diffIt) &&
+				((diffIt->Start < pieceEnd) ||
+				((diffIt->Start == pieceEnd) && (diffIt->End == pieceEnd) && !nextContinues)))
+		{
+			if((diffIt->Start < pos) || (pieceEnd < diffIt->End))
+			{
+				nfiError("Diff overlaps diff of an earlier round\n");
+				return -1;
+			}
+
+			if(pos < diffIt->Start)
+			{
+				pieces.push_back({pos, (size_t) (diffIt->Start - pos), true});
+			}
+
+			if(!diffIt->Replacement.empty())
+			{
+				pieces.push_back({diffIt->Replacement.data(), diffIt->Replacement.size(), false});
+				Profiler::Count(Profiler::COUNTER_DIFF_BYTES, diffIt->Replacement.size());
+			}
+
+			pos = diffIt->End;
+			diffIt++;
+		}
+
+		if(pos < pieceEnd)
+		{
+			pieces.push_back({pos, (size_t) (pieceEnd - pos), true});
+		}
+	}
+
+	if(edits.end() != diffIt)
 	{
-		diffElem.Replacement += "[0]";
-	}
-	else
-	{
-		diffElem.Replacement += "[" + std::to_string(fiSignal.Width - 1) + ":0]";
+		nfiError("Diff outside of content\n");
+		return -1;
 	}
-#endif // !FI_SINGLE_BIT
-
-	diffElem.Replacement += " : {"+ std::to_string(fiSignal.Width) + "{1'b0}})";
 
-	nfiDebug("Replacement: '%s'\n", diffElem.Replacement.c_str());
+	// Replacement pieces point into the diff's text, which moves over without copying
+	Replacements_.Adopt(std::move(diff.Text));
+	edits.clear();
 
+	Pieces_.swap(pieces);
 
-	nfiDebug("\n\n\n");
+	nfiDebug("%lu pieces after DiffApply\n", Pieces_.size());
 
 	return 0;
 }
 
-int RtlFile::FiEnableInputAdd(std::map<const char *, diff_t> * diff, const char * start, const char * stop)
+int RtlFile::WriteBack() const
 {
-	const char * ioEnd = strstr(start, ");");
-	if(nullptr == ioEnd)
+	// Pieces may point into the mapping of Name_, so never truncate it while writing
+	const std::string &name = Output_.empty() ? Name_ : Output_;
+	std::string tmpName;
+	const int fd = OutputOpen(&tmpName, name);
+	if(0 > fd)
 	{
-		nfiError("Could not find end of io\n");
+		nfiError("OutputOpen failed for %s\n", name.c_str());
 		return -1;
 	}
 
-	if(PosInsideComment(ioEnd, start, stop))
+	std::vector<piece_t> unedited;
+	const std::vector<piece_t> * pieces = &Pieces_;
+	if(Pieces_.empty())
 	{
-		return FiEnableInputAdd(diff, start, stop);
+		unedited.push_back({Content_, Size_, true});
+		pieces = &unedited;
 	}
 
-
-	const char * singleSemiColon = strchr(start, ';');
-	if((nullptr != singleSemiColon) && (singleSemiColon < ioEnd))
+	// Compressed files stay compressed
+	int ret;
+	if(Compression::COMPRESSION_NONE == Compression_)
 	{
-		nfiError("Unexpected ';'\n");
-		return -1;
+		ret = PiecesWrite(fd, *pieces);
+	}
+	else
+	{
+		Compressor compressor;
+		ret = compressor.Open(fd, Compression_, name.c_str()) || PiecesWrite(&compressor, *pieces) || compressor.Close();
 	}
 
-	const char * replaceStart = ioEnd; // before );
-
-	if(diff->end() != diff->find(replaceStart))
+	if(ret)
 	{
-		nfiError("ioEnd already diff'ed\n");
+		nfiError("PiecesWrite failed on %s\n", name.c_str());
+		OutputAbort(fd, tmpName);
 		return -1;
 	}
 
-	auto &diffIt = (*diff)[replaceStart];
-	diffIt.Replacement = ", ";
-	diffIt.Replacement += FiEnableStr;
-	diffIt.Replacement += ");\n input ";
-	diffIt.Replacement += FiEnableStr;
-	diffIt.Replacement += ";\n wire ";
-	diffIt.Replacement += FiEnableStr + std::string(";");
-
-	diffIt.End = ioEnd + 2; // after ");"
-
-	return 0;
+	return OutputCommit(fd, tmpName, name);
 }
 
-int RtlFile::ModuleFi(
-		bool isTop, const std::string &fiPrefix,
-		fiMode_t fiMode,
-		module_t * module, std::map<const char *, diff_t> * diff,
-		const char * start, const char * stop)
+// Hands the pieces to compressor, which copies them
+int RtlFile::PiecesWrite(Compressor * compressor, const std::vector<piece_t> &pieces)
 {
-	// Add Fi enable wire to inputs
-	if(!isTop)
+	for(const auto &piece: pieces)
 	{
-		if(FiEnableInputAdd(diff, start, stop))
+		if(compressor->Write(piece.Start, piece.Size))
 		{
-			nfiError("FiEnableInputAdd failed\n");
+			nfiError("Compressor::Write failed\n");
 			return -1;
 		}
+
+		Profiler::Count(Profiler::COUNTER_WRITE_BYTES, piece.Size);
 	}
 
-	// Find all fi needles and add corruption
-	const char * pos = start;
-	do {
-		size_t needleNr;
-		const char * needle = NextNeedle(&needleNr, pos, stop - pos);
-		if(nullptr == needle)
-		{
-			break; // no more needles
-		}
+	return 0;
+}
 
-		if(NeedleCorrupt(fiMode, module, diff, fiPrefix, start, stop, needle, (fiNeedle_t) needleNr))
+// Symlinks are followed, so the file they point to is replaced rather than the link
+static int outputTargetGet(std::string * target, const std::string &name)
+{
+	char * const resolved = realpath(name.c_str(), nullptr);
+	if(nullptr == resolved)
+	{
+		if(ENOENT != errno)
 		{
-			nfiError("NeedleCorrupt failed\n");
+			nfiError("realpath failed on %s\n", name.c_str());
 			return -1;
 		}
 
-		// prepare next loop
-		pos = needle + 1;
-
-	} while(pos < stop);
+		// A new file
+		errno = 0;
+		*target = name;
+		return 0;
+	}
 
+	*target = resolved;
+	free(resolved);
 
 	return 0;
 }
 
-int RtlFile::DiffApply(std::map<const char *, diff_t> &diff)
+// Writes the complete temporary file through target, which keeps its inode, i.e. hard links, owner and group
+static int tmpCopy(int tmpFd, const std::string &target)
 {
+	if(0 != lseek(tmpFd, 0, SEEK_SET))
+	{
+		nfiError("lseek failed\n");
+		return -1;
+	}
 
-	// check that there is no overlapping diff
-	auto lastIt = diff.begin();
-	for(auto it = diff.begin(); it != diff.end(); it++)
+	const int fd = open(target.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+	if(0 > fd)
+	{
+		nfiError("failed to open %s for writing\n", target.c_str());
+		return -1;
+	}
+
+	std::vector<char> buffer(1 << 16);
+	int ret = 0;
+	while(0 == ret)
 	{
-		if(it->first > it->second.End)
+		const ssize_t got = read(tmpFd, buffer.data(), buffer.size());
+		if(0 == got)
 		{
-			nfiError("Diff end before beginning\n");
-			return -1;
+			break;
 		}
 
-		if(it != diff.begin())
+		if(0 > got)
 		{
-			if(it->first <= lastIt->second.End)
+			if(EINTR == errno)
 			{
-				nfiError("Overlapping diff\n");
-				return -1;
+				errno = 0;
+				continue;
 			}
+
+			nfiError("read failed\n");
+			ret = -1;
+			break;
 		}
 
-		lastIt = it;
+		for(ssize_t done = 0; done < got;)
+		{
+			const ssize_t written = write(fd, buffer.data() + done, got - done);
+			if(0 > written)
+			{
+				if(EINTR == errno)
+				{
+					errno = 0;
+					continue;
+				}
+
+				nfiError("write failed on %s\n", target.c_str());
+				ret = -1;
+				break;
+			}
+
+			done += written;
+		}
 	}
 
-	// Calculate new file size
-	long fileSizeDiff = 0;
-	for(auto it = diff.begin(); it != diff.end(); it++)
+	if(close(fd) && (0 == ret))
 	{
-		const long originalSize = it->second.End - it->first;
-		const long newSize = it->second.Replacement.size();
-
-		fileSizeDiff += newSize - originalSize;
+		nfiError("close failed on %s\n", target.c_str());
+		ret = -1;
 	}
 
-	nfiDebug("fileSizeDiff = %li\n", fileSizeDiff);
+	return ret;
+}
 
-	// Create new content
-	const size_t newContentSize = Size_ + fileSizeDiff;
-	char * newContent = (char*) malloc(newContentSize);
-	if(nullptr == newContent)
+// Returns the fd of the temporary file, with the permissions, owner and group of name, or negative on error
+// A new name gets the permissions open would give it
+int RtlFile::TmpCreate(std::string * tmpName, const std::string &name)
+{
+	std::string target;
+	if(outputTargetGet(&target, name))
 	{
-		nfiError("malloc failed\n");
+		nfiError("outputTargetGet failed\n");
 		return -1;
 	}
 
-	// Reverse iterate through map to apply diff
-	newContent[newContentSize - 1] = '\0';
-	char * nextWritePosNew = &newContent[newContentSize - 2];
-	const char * lastReadPosOld = &Content_[Size_ - 1];
-	for(auto it = diff.rbegin(); it != diff.rend(); it++)
+	struct stat fileStat;
+	const bool exists = (0 == stat(target.c_str(), &fileStat));
+	if(!exists)
 	{
-		// Copy old to new
-		if(lastReadPosOld <= it->second.End)
+		if(ENOENT != errno)
 		{
-			nfiError("last Read position too large\n");
-			free(newContent);
+			nfiError("stat failed on file %s\n", target.c_str());
 			return -1;
 		}
-		const size_t oldToCopySize = lastReadPosOld - it->second.End;
 
-		nextWritePosNew -= oldToCopySize - 1;
-		if(newContent > nextWritePosNew)
-		{
-			nfiError("Copy size too large\n");
-			free(newContent);
-			return -1;
-		}
-		memcpy(nextWritePosNew, lastReadPosOld - oldToCopySize, oldToCopySize);
+		errno = 0;
+	}
 
-		// Copy diff
-		nextWritePosNew -= it->second.Replacement.size();
-		if(newContent > nextWritePosNew)
+	// Created like a new file, i.e. the kernel applies the umask, names differ per process and call
+	// Readable, as TmpCommit may copy it
+	static std::atomic<size_t> tmpCnt(0);
+	int fd = -1;
+	for(size_t attempt = 0; (0 > fd) && (attempt < 100); attempt++)
+	{
+		*tmpName = target + ".nfi" + std::to_string(getpid()) + "_" + std::to_string(tmpCnt++);
+		fd = open(tmpName->c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+		if((0 > fd) && (EEXIST != errno))
 		{
-			nfiError("diff size too large\n");
-			free(newContent);
-			return -1;
+			break;
 		}
-		memcpy(nextWritePosNew, it->second.Replacement.c_str(), it->second.Replacement.size());
-
-		nextWritePosNew--;
-		lastReadPosOld = it->first;
 	}
 
-	// Copy old to new
-	if(lastReadPosOld <= Content_)
+	if(0 > fd)
 	{
-		nfiError("last Read position too large\n");
-		free(newContent);
+		nfiError("failed to create temporary file %s\n", tmpName->c_str());
 		return -1;
 	}
-	const size_t oldToCopySize = lastReadPosOld - Content_;
 
-	nextWritePosNew -= oldToCopySize - 1;
-	if(newContent != nextWritePosNew)
+	errno = 0;
+
+	if(!exists)
+	{
+		return fd;
+	}
+
+	// A replaced file keeps its permissions
+	if(fchmod(fd, fileStat.st_mode & 07777))
 	{
-		nfiError("Not at beginning of new content by end of diff application\n");
-		free(newContent);
+		nfiError("fchmod failed on %s\n", tmpName->c_str());
+		close(fd);
+		unlink(tmpName->c_str());
 		return -1;
 	}
 
-	const char * oldContentBeginning = lastReadPosOld - oldToCopySize;
-	if(Content_ != oldContentBeginning)
+	// Only permitted for some owners and groups, TmpCommit copies instead of renaming otherwise
+	if(fchown(fd, fileStat.st_uid, fileStat.st_gid))
+	{
+		errno = 0;
+	}
+
+	return fd;
+}
+
+// Closes fd and renames the temporary file to name, the temporary file is removed in any case
+// Hard linked names and ones the temporary file couldn't take the owner or group of are overwritten with its content
+int RtlFile::TmpCommit(int fd, const std::string &tmpName, const std::string &name)
+{
+	std::string target;
+	struct stat fileStat;
+	struct stat tmpStat;
+	if(outputTargetGet(&target, name) || fstat(fd, &tmpStat))
 	{
-		nfiError("Not at beginning of old content by end of diff application\n");
-		free(newContent);
+		nfiError("failed to find the target of %s\n", name.c_str());
+		close(fd);
+		unlink(tmpName.c_str());
 		return -1;
 	}
 
-	memcpy(nextWritePosNew, oldContentBeginning, oldToCopySize);
+	if(0 == stat(target.c_str(), &fileStat) &&
+		((1 < fileStat.st_nlink) || (fileStat.st_uid != tmpStat.st_uid) || (fileStat.st_gid != tmpStat.st_gid)))
+	{
+		// All pieces are written, so the mapping of an input written in place is no longer read
+		const int ret = tmpCopy(fd, target);
+		close(fd);
+		unlink(tmpName.c_str());
+		if(ret)
+		{
+			nfiError("tmpCopy failed to %s\n", target.c_str());
+		}
+
+		return ret;
+	}
+
+	errno = 0;
+
+	if(close(fd))
+	{
+		nfiError("close failed\n");
+		unlink(tmpName.c_str());
+		return -1;
+	}
 
-	free(Content_);
-	Content_ = newContent;
-	Size_ = newContentSize;
+	if(rename(tmpName.c_str(), target.c_str()))
+	{
+		nfiError("rename %s to %s failed\n", tmpName.c_str(), target.c_str());
+		unlink(tmpName.c_str());
+		return -1;
+	}
 
 	return 0;
 }
 
-int RtlFile::WriteBack() const
+std::string RtlFile::OutputName(const std::string &output, const std::string &input)
 {
-	FILE * pFile = fopen(Name_.c_str(), "w");
-	if(nullptr == pFile)
+	if(output.empty() || (0 == strcmp(output.c_str(), StdioName)))
 	{
-		nfiError("failed to open file %s\n", Name_.c_str());
-		return -1;
+		return output.empty() ? input : output;
+	}
+
+	struct stat outputStat;
+	if(stat(output.c_str(), &outputStat) || !S_ISDIR(outputStat.st_mode))
+	{
+		errno = 0;
+		return output;
+	}
+
+	const size_t slash = input.rfind('/');
+	return output + "/" + ((std::string::npos == slash) ? input : input.substr(slash + 1));
+}
+
+// Returns the fd to write name to, or negative on error
+int RtlFile::OutputOpen(std::string * tmpName, const std::string &name)
+{
+	tmpName->clear();
+
+	// stdout may take several files one after the other
+	if(0 == strcmp(name.c_str(), StdioName))
+	{
+		return STDOUT_FILENO;
 	}
 
-	fwrite(Content_, 1, Size_ - 1, pFile); // don't write '\0' back
+	struct stat fileStat;
+	if(stat(name.c_str(), &fileStat) || S_ISREG(fileStat.st_mode))
+	{
+		errno = 0;
+		return TmpCreate(tmpName, name);
+	}
 
-	if(fclose(pFile))
+	// e.g. a FIFO of the next tool, which must not be replaced
+	const int fd = open(name.c_str(), O_WRONLY);
+	if(0 > fd)
 	{
-		nfiError("fclose failed\n");
+		nfiError("failed to open %s for writing\n", name.c_str());
 		return -1;
 	}
 
-	return 0;
+	return fd;
 }
 
-int RtlFile::ModuleInstancesHandle(
-		std::map<std::string, module_t>::iterator &currentModule,
-		std::map<std::string, module_t> * modules, std::map<const char *, diff_t> * diff,
-		const char * moduleStart, const char * moduleEnd,
-		const std::string &topModule,
-		size_t hierarchyDepth)
+int RtlFile::OutputCommit(int fd, const std::string &tmpName, const std::string &name)
 {
-	// In top module the fi signal does not need a "top." up front
-	std::string fiEnableSignalStr;
-	if(currentModule->first == topModule)
+	if(!tmpName.empty())
 	{
-		fiEnableSignalStr = std::string(GlobalFiModInstNumber_);
+		return TmpCommit(fd, tmpName, name);
 	}
-	else
+
+	if((STDOUT_FILENO != fd) && close(fd))
 	{
-		fiEnableSignalStr = topModule + "." + std::string(GlobalFiModInstNumber_);
+		nfiError("close failed on %s\n", name.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+void RtlFile::OutputAbort(int fd, const std::string &tmpName)
+{
+	if(STDOUT_FILENO != fd)
+	{
+		close(fd);
 	}
 
-	// Find module instantiations and add fiEnable signal to end
-	for(auto &module : *modules)
+	if(!tmpName.empty())
 	{
-		const char * currPos = moduleStart;
-		do {
-			// Find next instantiation
-			const char * instStart = strstr(currPos, module.first.c_str());
-			if((nullptr == instStart) || (moduleEnd < instStart))
-			{
-				break; // no more instances of this module in this module
-			}
+		unlink(tmpName.c_str());
+	}
+}
 
-			if(' ' != *(instStart + module.first.size()) || // space between module name and instance name
-					!isSpace(*(instStart - 1)) || // otherwise "xxx<moduleName>" would be interpreted as instance of <moduleName>
-					PosInsideComment(instStart, moduleStart, moduleEnd))
-			{
-				currPos = instStart + 1;
-				continue;
-			}
+// Gathers the pieces straight from the original content and replacement storage
+int RtlFile::PiecesWrite(int fd, const std::vector<piece_t> &pieces)
+{
+	std::vector<struct iovec> iov(IOV_MAX);
 
-			nfiDebug("\tFound instance of '%s'\n", module.first.c_str());
+	size_t pieceNr = 0;
+	while(pieceNr < pieces.size())
+	{
+		size_t iovCnt = 0;
+		while((iovCnt < iov.size()) && (pieceNr + iovCnt < pieces.size()))
+		{
+			iov[iovCnt].iov_base = (void *) pieces[pieceNr + iovCnt].Start;
+			iov[iovCnt].iov_len = pieces[pieceNr + iovCnt].Size;
+			iovCnt++;
+		}
 
-			// Add it to module instances vector
-			const size_t instUuid = uuidGet();
-			currentModule->second.InstanceUuids.push_back({&module, instUuid});
+		pieceNr += iovCnt;
 
-			// Add fiEnable to end of inputs
-			const char * endOfInputs = strstr(instStart, ");");
-			if((nullptr == endOfInputs) || (moduleEnd < endOfInputs))
+		// Continue partial writes where they stopped
+		struct iovec * iovPos = iov.data();
+		while(0 < iovCnt)
+		{
+			const ssize_t written = writev(fd, iovPos, iovCnt);
+			if(0 > written)
 			{
-				nfiError("Could not find end of inputs for module instance\n");
-				return -1;
-			}
+				if(EINTR == errno)
+				{
+					continue;
+				}
 
-			// Check for illegal semi-colon in between
-			const char * illSemiColon = strchr(instStart, ';');
-			if((nullptr != illSemiColon) && (illSemiColon < endOfInputs))
-			{
-				nfiError("Unexpected semi-colon in inputs for module instance\n");
+				nfiError("writev failed\n");
 				return -1;
 			}
 
-			endOfInputs--; // before end of inputs
-			while(('\n' == *endOfInputs) || (' ' == *endOfInputs))
+			Profiler::Count(Profiler::COUNTER_WRITE_BYTES, written);
+
+			size_t remaining = written;
+			while((0 < iovCnt) && (iovPos->iov_len <= remaining))
 			{
-				endOfInputs--;
+				remaining -= iovPos->iov_len;
+				iovPos++;
+				iovCnt--;
 			}
-			endOfInputs += 1;
 
-			if(diff->end() != diff->find(endOfInputs))
+			if(0 < iovCnt)
 			{
-				nfiError("diff already in diff map\n");
-				return -1;
+				iovPos->iov_base = (char *) iovPos->iov_base + remaining;
+				iovPos->iov_len -= remaining;
 			}
+		}
+	}
+
+	return 0;
+}
+
+// Resolves the instance statements of all modules to the instantiated modules of the design in a single pass
+// Per module, instances of netlist modules come first, ordered by module name, then by position,
+// as UUIDs are handed out in this order
+int RtlFile::InstancesResolve(const moduleTable_t &modules)
+{
+	Instances_.clear();
+	Instances_.resize(ModuleIndex_.size());
 
-			auto &diffIt = (*diff)[endOfInputs];
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
+	{
+		const moduleIndex_t &entry = ModuleIndex_[index];
+		std::vector<instance_t> &moduleInstances = Instances_[index];
 
-			diffIt.End = endOfInputs;
-			diffIt.Replacement = ",\n";
-			diffIt.Replacement += "    ." + std::string(FiEnableStr) + "(";
-			diffIt.Replacement += std::string(FiEnableStr) + " && (";
-			for(size_t hier = 0; hier < hierarchyDepth; hier++)
+		if(nullptr != Cached_[index])
+		{
+			for(const auto &instance: Cached_[index]->Instances)
 			{
-				diffIt.Replacement += "(" + std::to_string(instUuid) + " == " +
-						std::string(fiEnableSignalStr) + "[" + std::to_string(hier) + "])";
+				if(entry.End - entry.Start <= instance.InputsEnd)
+				{
+					nfiError("Cached instance outside of module %s\n", entry.Name.c_str());
+					return -1;
+				}
 
-				if(hier < hierarchyDepth - 1)
+				moduleInstances.push_back({ModuleIdNone_, instance.Type, Content_ + entry.Start + instance.InputsEnd, instance.UUID});
+			}
+		}
+		else
+		{
+			const statement_t * const statements = Statements_.data() + entry.StatementsStart;
+			for(size_t nr = 0; nr < entry.StatementsCnt; nr++)
+			{
+				const statement_t &statement = statements[nr];
+				if(STATEMENT_INSTANCE != statement.Type)
 				{
-					diffIt.Replacement += " || ";
+					continue;
 				}
+
+				moduleInstances.push_back({ModuleIdNone_, std::string_view(statement.Start, statement.NameEnd - statement.Start),
+						InputsEndGet(statement), 0});
+			}
+		}
+
+		for(auto &instance: moduleInstances)
+		{
+			const auto idIt = modules.Ids.find(instance.Type);
+			if(modules.Ids.end() == idIt)
+			{
+				continue; // e.g. cell of a library
 			}
-			diffIt.Replacement +="))";
 
-			currPos = endOfInputs;
+			nfiDebug("\t%s: found instance of '%.*s'\n", entry.Name.c_str(), (int) instance.Type.size(), instance.Type.data());
 
-		} while (currPos < moduleEnd);
+			instance.Module = idIt->second;
+		}
+
+		// Ids follow module names and ModuleIdNone_ is the largest id, so this also puts unresolved instances last
+		std::stable_sort(moduleInstances.begin(), moduleInstances.end(),
+				[](const instance_t &a, const instance_t &b) { return a.Module < b.Module; });
 	}
 
 	return 0;
 }
 
-int RtlFile::GlobalSignalsToTopAdd(std::map<const char *, diff_t> * diff, const char * start, const char * stop, size_t fiSignalWidth, size_t hierarchyDepth)
+// Returns where fiEnable is connected to the instance, i.e. before the statement's ')'
+const char * RtlFile::InputsEndGet(const statement_t &instance)
 {
-	const char * ioEnd = strstr(start, ");");
-	if(nullptr == ioEnd)
+	const char * inputsEnd = instance.End - 2;
+	while(('\n' == *inputsEnd) || (' ' == *inputsEnd))
 	{
-		nfiError("Could not find end of io\n");
-		return -1;
+		inputsEnd--;
 	}
 
-	if(PosInsideComment(ioEnd, start, stop))
+	return inputsEnd + 1;
+}
+
+int RtlFile::ModuleInstancesHandle(
+		moduleTable_t * modules, moduleId_t id,
+		std::vector<instance_t> &instances, diffList_t * diff,
+		const std::string &topModule,
+		size_t hierarchyDepth, size_t * uuidNext)
+{
+	// In top module the fi signal does not need a "top." up front
+	std::string fiEnableSignalStr;
+	if(modules->Top == id)
+	{
+		fiEnableSignalStr = std::string(GlobalFiModInstNumber_);
+	}
+	else
 	{
-		return GlobalSignalsToTopAdd(diff, start, stop, fiSignalWidth, hierarchyDepth);
+		fiEnableSignalStr = topModule + "." + std::string(GlobalFiModInstNumber_);
 	}
 
-	const char * singleSemiColon = strchr(start, ';');
-	if((nullptr != singleSemiColon) && (singleSemiColon < ioEnd))
+	const module_t &module = modules->Modules[id];
+	if((module.EdgesCnt > instances.size()) ||
+			((module.EdgesCnt < instances.size()) && (ModuleIdNone_ != instances[module.EdgesCnt].Module)))
 	{
-		nfiError("Unexpected ';'\n");
+		nfiError("Instances don't match module hierarchy\n");
 		return -1;
 	}
 
-	const char * replaceStart = ioEnd; // before );
-
-	if(diff->end() != diff->find(replaceStart))
+	// Add fiEnable signal to end of each instance's inputs
+	for(size_t inst = 0; inst < module.EdgesCnt; inst++)
 	{
-		nfiError("ioEnd already diff'ed\n");
-		return -1;
+		instance_t &instance = instances[inst];
+
+		// Hierarchy was built from the same instances, only the UUID is missing
+		if(0 == instance.UUID)
+		{
+			instance.UUID = (*uuidNext)++;
+		}
+
+		const size_t instUuid = instance.UUID;
+		modules->EdgeUuids[module.EdgesStart + inst] = instUuid;
+
+		const char * const endOfInputs = instance.InputsEnd;
+
+		TextArena &text = diff->Text;
+		text.Append(",\n    .");
+		text.Append(FiEnableStr);
+		text.Append("(");
+		text.Append(FiEnableStr);
+		text.Append(" && (");
+		for(size_t hier = 0; hier < hierarchyDepth; hier++)
+		{
+			text.Append("(");
+			text.AppendNumber(instUuid);
+			text.Append(" == ");
+			text.Append(fiEnableSignalStr);
+			text.Append("[");
+			text.AppendNumber(hier);
+			text.Append("])");
+
+			if(hier < hierarchyDepth - 1)
+			{
+				text.Append(" || ");
+			}
+		}
+		text.Append("))");
+
+		diff->Edits.push_back({endOfInputs, endOfInputs, text.Finish()});
 	}
 
-	auto &diffIt = (*diff)[replaceStart];
-	diffIt.Replacement = ", ";
-	diffIt.Replacement += std::string(GlobalFiSignal_) + ", ";
-	diffIt.Replacement += std::string(GlobalFiNumber_) + ", ";
-	diffIt.Replacement += GlobalFiModInstNumber_;
-	diffIt.Replacement += ");\n";
-	diffIt.Replacement += "input " + std::string(GlobalFiSignal_) + ";\n";
-	diffIt.Replacement += "wire [" + std::to_string(fiSignalWidth - 1) + ":0] " + std::string(GlobalFiSignal_) + ";\n";
-	diffIt.Replacement += "input " + std::string(GlobalFiNumber_) + ";\n";
-	diffIt.Replacement += "wire [31:0] " + std::string(GlobalFiNumber_) + ";\n";
-	diffIt.Replacement += "input " + std::string(GlobalFiModInstNumber_) + ";\n";
-	diffIt.Replacement += "wire [15:0] " + std::string(GlobalFiModInstNumber_) + "[" + std::to_string(hierarchyDepth) + "];\n";
-	diffIt.Replacement += "wire " + std::string(FiEnableStr) + ";\n";
-	diffIt.Replacement += "assign " + std::string(FiEnableStr) +	" = ";
+	return 0;
+}
+
+int RtlFile::GlobalSignalsToTopAdd(diffList_t * diff, const statement_t &portList, size_t fiSignalWidth, size_t hierarchyDepth)
+{
+	const char * ioEnd = portList.End - 1;
+	const char * replaceStart = ioEnd; // before );
+
+	// Only once per design, so readability wins over appending piece by piece
+	std::string replacement = ", ";
+	replacement += std::string(GlobalFiSignal_) + ", ";
+	replacement += std::string(GlobalFiNumber_) + ", ";
+	replacement += GlobalFiModInstNumber_;
+	replacement += ");\n";
+	replacement += "input " + std::string(GlobalFiSignal_) + ";\n";
+	replacement += "wire [" + std::to_string(fiSignalWidth - 1) + ":0] " + std::string(GlobalFiSignal_) + ";\n";
+	replacement += "input " + std::string(GlobalFiNumber_) + ";\n";
+	replacement += "wire [31:0] " + std::string(GlobalFiNumber_) + ";\n";
+	replacement += "input " + std::string(GlobalFiModInstNumber_) + ";\n";
+	replacement += "wire [15:0] " + std::string(GlobalFiModInstNumber_) + "[" + std::to_string(hierarchyDepth) + "];\n";
+	replacement += "wire " + std::string(FiEnableStr) + ";\n";
+	replacement += "assign " + std::string(FiEnableStr) +	" = ";
 	for(int hier = 0; hier < hierarchyDepth; hier++)
 	{
-		diffIt.Replacement += "(" + std::to_string(GlobalFiModInstNumberTop_)+ " == " +
+		replacement += "(" + std::to_string(GlobalFiModInstNumberTop_)+ " == " +
 				std::string(GlobalFiModInstNumber_) + "[" + std::to_string(hier) + "])";
 
 		if(hier != hierarchyDepth - 1)
 		{
-			diffIt.Replacement += " || ";
+			replacement += " || ";
 		}
 	}
-	diffIt.Replacement += ";\n";
+	replacement += ";\n";
 
-	diffIt.End = ioEnd + 2; // after ");"
+	diff->Text.Append(replacement);
+	diff->Edits.push_back({replaceStart, ioEnd + 2, diff->Text.Finish()}); // up to after ");"
 
 	return 0;
 }
@@ -1557,79 +2707,161 @@ const std::string &RtlFile::signalTypeStr(signalType_t type)
 	case SIGNAL_TYPE_OUTPUT:
 		return strings[type];
 
-	default:
-		nfiError("Unknown type\n");
-		return strings[SIGNAL_TYPE_NROF];
-	}
+	default:
+		nfiError("Unknown type\n");
+		return strings[SIGNAL_TYPE_NROF];
+	}
+
+	// coverity[UNREACHABLE]
+	return strings[SIGNAL_TYPE_NROF];
+}
+
+// Marks the top module and all modules instantiated below it
+void RtlFile::ReachableMark(moduleTable_t * modules)
+{
+	for(auto &module: modules->Modules)
+	{
+		module.Reachable = false;
+	}
+
+	std::vector<moduleId_t> stack = {modules->Top};
+	modules->Modules[modules->Top].Reachable = true;
+
+	while(!stack.empty())
+	{
+		const module_t &module = modules->Modules[stack.back()];
+		stack.pop_back();
+
+		for(size_t edge = module.EdgesStart; edge < module.EdgesStart + module.EdgesCnt; edge++)
+		{
+			module_t &child = modules->Modules[modules->EdgeModules[edge]];
+			if(!child.Reachable)
+			{
+				child.Reachable = true;
+				stack.push_back(modules->EdgeModules[edge]);
+			}
+		}
+	}
+}
+
+// Sets the subtree totals of all reachable modules in one pass over the module graph, children before parents
+// Each module is visited once, however often it is instantiated, so reused blocks don't multiply the work
+int RtlFile::HierarchyAnalyze(moduleTable_t * modules)
+{
+	typedef enum {
+		VISIT_NEW,
+		VISIT_OPEN, // on the stack, i.e. an edge to it closes a cycle
+		VISIT_DONE
+	} visit_t;
+
+	typedef struct {
+		moduleId_t Module;
+		size_t Edge; // next edge to follow
+	} frame_t;
+
+	std::vector<visit_t> visits(modules->Modules.size(), VISIT_NEW);
+	std::vector<frame_t> stack;
+
+	for(moduleId_t root = 0; root < modules->Modules.size(); root++)
+	{
+		if((VISIT_NEW != visits[root]) || !modules->Modules[root].Reachable)
+		{
+			continue;
+		}
+
+		visits[root] = VISIT_OPEN;
+		stack.push_back({root, 0});
+
+		while(!stack.empty())
+		{
+			frame_t &frame = stack.back();
+			module_t &module = modules->Modules[frame.Module];
+
+			if(frame.Edge < module.EdgesCnt)
+			{
+				const moduleId_t child = modules->EdgeModules[module.EdgesStart + frame.Edge];
+				frame.Edge++;
+
+				if(VISIT_NEW == visits[child])
+				{
+					visits[child] = VISIT_OPEN;
+					stack.push_back({child, 0}); // invalidates frame
+				}
+				else if(VISIT_OPEN == visits[child])
+				{
+					std::string cycle;
+					for(auto it = stack.begin(); it != stack.end(); it++)
+					{
+						if(it->Module == child)
+						{
+							for(; it != stack.end(); it++)
+							{
+								cycle += std::string(modules->Modules[it->Module].Name) + " -> ";
+							}
+							break;
+						}
+					}
+
+					nfiError("Modules instantiate each other: %s%s\n", cycle.c_str(), std::string(modules->Modules[child].Name).c_str());
+					return -1;
+				}
+
+				continue;
+			}
+
+			// All instantiated modules are done
+			module.SubtreeDepth = 0;
+			module.SubtreeInstances = 1;
+			module.SubtreeBits = 0;
 
-	// coverity[UNREACHABLE]
-	return strings[SIGNAL_TYPE_NROF];
-}
+			for(const auto &signal: module.FiSignal)
+			{
+				module.SubtreeBits += signal.Width;
+			}
 
-// TODO: The fact that this function exists is ridiculous
-int RtlFile::MapOffsetsCalculate(std::map<std::string, size_t> * offsets, const std::map<std::string, module_t> &modules)
-{
-	size_t offset = 0;
-	for(auto it = modules.begin(); it != modules.end(); it++)
-	{
-		(*offsets)[it->first] = offset;
-		offset++;
+			for(size_t edge = module.EdgesStart; edge < module.EdgesStart + module.EdgesCnt; edge++)
+			{
+				const module_t &child = modules->Modules[modules->EdgeModules[edge]];
+				module.SubtreeDepth = std::max(module.SubtreeDepth, child.SubtreeDepth);
+				module.SubtreeInstances += child.SubtreeInstances;
+				module.SubtreeBits += child.SubtreeBits;
+			}
+
+			module.SubtreeDepth++; // adding itself
+
+			visits[frame.Module] = VISIT_DONE;
+			stack.pop_back();
+		}
 	}
 
 	return 0;
 }
 
-// Returns <= 0 on error
-int RtlFile::HierarchyDepthGet(const std::map<std::string, module_t> &modules, const std::string &topName)
+int RtlFile::HierarchyPrint(FILE * file, const moduleTable_t &modules)
 {
-	auto topIt = modules.find(topName);
-	if(modules.end() == topIt)
+	if(modules.Modules.size() <= modules.Top)
 	{
-		nfiError("Could not find module %s\n", topName.c_str());
+		nfiError("No top module\n");
 		return -1;
 	}
 
-	// Get depth of each instance
-	// Or stop recursion if module contains no instances
-	std::vector<int> instDepth(topIt->second.InstanceUuids.size());
-	for(size_t inst = 0; inst < topIt->second.InstanceUuids.size(); inst++)
-	{
-		const module_t * modPt = (module_t*) topIt->second.InstanceUuids[inst].first;
-		instDepth[inst] = HierarchyDepthGet(modules, modPt->Name);
-
-		if(0 >= instDepth[inst])
-		{
-			nfiError("HierarchyDepthGet failed\n");
-			return -1;
-		}
-	}
-
-	// find deepest depth
-	int deepestDepth = 0;
-	for(const auto &depth: instDepth)
+	const module_t &top = modules.Modules[modules.Top];
+	if(0 > fprintf(file, "Hierarchy depth %lu, %lu module instances, %lu fault bits\n",
+			top.SubtreeDepth, top.SubtreeInstances, top.SubtreeBits))
 	{
-		if(deepestDepth < depth)
-		{
-			deepestDepth = depth;
-		}
+		nfiError("fprintf failed\n");
+		return -1;
 	}
 
-	return deepestDepth + 1; // adding itself
+	return 0;
 }
 
-int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const std::string &topName)
+// Reachable modules are listed in id order, unreachable ones are left out and don't take an index
+int RtlFile::LibraryCreate(const moduleTable_t &modules, const std::string &topName, const std::string &libraryName)
 {
-	// TODO: Don't reference by pointer to map element!!
-	std::map<std::string, size_t> moduleOffsets;
-	if(MapOffsetsCalculate(&moduleOffsets, modules))
-	{
-		nfiError("MapOffsetsCalculate failed\n");
-		return -1;
-	}
-
-	// Continue with the actual business
-	const std::string fileName = topName + FiSignalsLibraryNameAppend_;
-	FILE* filep = fopen(fileName.c_str(), "w");
+	const std::string fileName = libraryName.empty() ? topName + FiSignalsLibraryNameAppend_ : libraryName;
+	const bool stdoutUsed = (0 == strcmp(fileName.c_str(), StdioName));
+	FILE* filep = stdoutUsed ? stdout : fopen(fileName.c_str(), "w");
 	if(NULL == filep)
 	{
 		nfiError("Failed to write-open %s\n", fileName.c_str());
@@ -1642,24 +2874,42 @@ int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const
 
 	header += "const std::vector<module_t> modules = {\n";
 
+	std::vector<size_t> libraryIndices(modules.Modules.size(), SIZE_MAX);
+	size_t libraryIndex = 0;
+	for(size_t id = 0; id < modules.Modules.size(); id++)
+	{
+		if(modules.Modules[id].Reachable)
+		{
+			libraryIndices[id] = libraryIndex++;
+		}
+	}
+
 	if(0 >= fprintf(filep, "%s", header.c_str()))
 	{
 		nfiError("Writing to %s failed\n", fileName.c_str());
-		fclose(filep);
+		if(!stdoutUsed)
+		{
+			fclose(filep);
+		}
 		return -1;
 	}
 
 	// Print values
-	for(const auto &module: modules)
+	for(const auto &module: modules.Modules)
 	{
+		if(!module.Reachable)
+		{
+			continue;
+		}
+
 		std::string moduleNameNoEscape;
-		backslashToDoubleBackslash(&moduleNameNoEscape, module.first);
+		backslashToDoubleBackslash(&moduleNameNoEscape, module.Name);
 
 		std::string toPrint;
 		toPrint += "\t{\n"; // start module
 		toPrint += "\t\t\"" + moduleNameNoEscape + "\",\n"; // module name
 		toPrint += "\t\t{\n"; // start std::vector<signal_t>
-		for(const auto &signal: module.second.FiSignal)
+		for(const auto &signal: module.FiSignal)
 		{
 			toPrint += "\t\t\t{\n"; // start signal_t
 			toPrint += "\t\t\t\t" + signalTypeStr(signal.Type) + ",\n";
@@ -1672,9 +2922,9 @@ int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const
 		toPrint += "\t\t},\n"; // stop std::vector<signal_t>
 
 		toPrint += "\t\t{\n"; // start std::vector<std::pair<size_t, size_t>> InstanceUuids
-		for(const auto &instance: module.second.InstanceUuids)
+		for(size_t edge = module.EdgesStart; edge < module.EdgesStart + module.EdgesCnt; edge++)
 		{
-			toPrint += "\t\t\t{" + std::to_string(moduleOffsets[((module_t*)instance.first)->Name]) + ", " + std::to_string(instance.second) + "},\n";
+			toPrint += "\t\t\t{" + std::to_string(libraryIndices[modules.EdgeModules[edge]]) + ", " + std::to_string(modules.EdgeUuids[edge]) + "},\n";
 		}
 		toPrint += "\t\t}\n"; // stop std::vector<std::pair<size_t, size_t>> InstanceUuids
 		toPrint += "\t},\n"; // end module
@@ -1683,7 +2933,10 @@ int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const
 		if(0 >= fprintf(filep, "%s", toPrint.c_str()))
 		{
 			nfiError("Writing to %s failed\n", fileName.c_str());
-			fclose(filep);
+			if(!stdoutUsed)
+			{
+				fclose(filep);
+			}
 			return -1;
 		}
 	}
@@ -1691,17 +2944,30 @@ int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const
 	std::string footer;
 	footer += "}; // modules\n\n";
 
-	footer += "const size_t modulesTopIndex = " + std::to_string(moduleOffsets[topName]) + ";\n\n";
+	footer += "const std::vector<size_t> modulesFiBits = {\n";
+	for(const auto &module: modules.Modules)
+	{
+		if(module.Reachable)
+		{
+			footer += "\t" + std::to_string(module.SubtreeBits) + ",\n";
+		}
+	}
+	footer += "}; // modulesFiBits\n\n";
+
+	footer += "const size_t modulesTopIndex = " + std::to_string(libraryIndices[modules.Top]) + ";\n\n";
 	footer += "const size_t modulesTopUUID = " + std::to_string(GlobalFiModInstNumberTop_) + ";\n\n";
 
 	if(0 >= fprintf(filep, "%s", footer.c_str()))
 	{
 		nfiError("Writing to %s failed\n", fileName.c_str());
-		fclose(filep);
+		if(!stdoutUsed)
+		{
+			fclose(filep);
+		}
 		return -1;
 	}
 
-	if(fclose(filep))
+	if(stdoutUsed ? fflush(filep) : fclose(filep))
 	{
 		nfiError("Closing Distribution Export file failed\n");
 		return -1;
@@ -1710,276 +2976,309 @@ int RtlFile::LibraryCreate(const std::map<std::string, module_t> &modules, const
 	return 0;
 }
 
-int RtlFile::FiSignalsCreate(fiMode_t fiMode)
+// Stores the results of this run for all modules of this file
+// cache must not be the cache of this run, cached modules are copied from there
+int RtlFile::CacheUpdate(FiCache * cache, const moduleTable_t &modules) const
 {
-	if(nullptr == Content_)
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
 	{
-		nfiError("Nullptr\n");
-		return -1;
-	}
-
-	nfiDebug("Create fi signals for all modules\n");
-
-	// Get all module names
-	std::map<std::string, module_t> modules; // <module name, module_t> // TODO: Does this really need to be a map?
-	const char * filePos = Content_;
-	do {
-		nfiDebug("Find next module\n");
-		std::string moduleName;
-		const char * moduleStart;
-		const char * moduleEnd;
-		const int modFindRet = ModuleFind(
-				&moduleName, &moduleStart, &moduleEnd,
-				filePos, Size_ - (filePos - Content_));
-
-		if(0 > modFindRet)
-		{
-			nfiError("moduleFind failed\n");
-			return -1;
-		}
-		else if(0 == modFindRet)
-		{
-			break;
-		}
+		const moduleIndex_t &entry = ModuleIndex_[index];
+		const char * const moduleStart = Content_ + entry.Start;
 
-		if(200 < moduleName.size())
+		// Unchanged module, so are its sites and instances
+		if(nullptr != Cached_[index])
 		{
-			nfiError("Module name longer than 200 chars: %.200s\n", moduleName.c_str());
-			return -1;
+			cache->Store(entry.Name, FiCache::entry_t(*Cached_[index]));
+			continue;
 		}
 
-		nfiDebug("\tFound module %s\n", moduleName.c_str());
-
-		if(modules.end() != modules.find(moduleName))
+		// Not instrumented, so there is nothing to reuse
+		if(!modules.Modules[entry.Id].Reachable)
 		{
-			nfiError("Module already in modules\n");
-			return -1;
+			continue;
 		}
 
-		modules[moduleName].Name = moduleName;
-
-		// Prepare next round
-		filePos = moduleEnd;
-
-	} while(filePos < Content_ + Size_);
-
-	// Get module instance hierarchy
-	filePos = Content_;
-	do {
-		std::string moduleName;
-		const char * moduleStart;
-		const char * moduleEnd;
-		const int modFindRet = ModuleFind(
-				&moduleName, &moduleStart, &moduleEnd,
-				filePos, Size_ - (filePos - Content_));
+		FiCache::entry_t cacheEntry;
+		cacheEntry.Hash = Keys_[index];
 
-		if(0 > modFindRet)
-		{
-			nfiError("moduleFind failed\n");
-			return -1;
-		}
-		else if(0 == modFindRet)
+		for(const auto &signal: modules.Modules[entry.Id].FiSignal)
 		{
-			break;
+			cacheEntry.Sites.push_back({signal.SiteStart - entry.Start, signal.SiteEnd - entry.Start,
+					signal.Width, signal.UUID, ""});
+			fiNameGet(&cacheEntry.Sites.back().Name, signal.Target);
 		}
 
-		nfiDebug("Module declaration %s\n", moduleName.c_str());
-		auto modIt = modules.find(moduleName);
-		if(modules.end() == modIt)
+		for(const auto &instance: Instances_[index])
 		{
-			nfiError("No such module in list\n");
-			return -1;
+			cacheEntry.Instances.push_back({(size_t) (instance.InputsEnd - moduleStart),
+					(ModuleIdNone_ != instance.Module) ? instance.UUID : 0, std::string(instance.Type)});
 		}
 
-		// Find module instantiations
-		for(auto &module : modules)
-		{
-			const char * currPos = moduleStart;
-			do {
-				// Find next instantiation
-				const char * instStart = strstr(currPos, module.first.c_str());
-				if((nullptr == instStart) || (moduleEnd < instStart))
-				{
-					break; // no more instances of this module in this module
-				}
-
-				if(' ' != *(instStart + module.first.size()) || // space between module name and instance name
-						PosInsideComment(instStart, moduleStart, moduleEnd))
-				{
-					currPos = instStart + 1;
-					continue;
-				}
-
-				nfiDebug("\tFound instance of '%s'\n", module.first.c_str());
+		std::sort(cacheEntry.Instances.begin(), cacheEntry.Instances.end(),
+				[](const FiCache::instance_t &a, const FiCache::instance_t &b) { return a.InputsEnd < b.InputsEnd; });
 
-				modIt->second.InstanceUuids.push_back({&module, 0}); // TODO: Dirty - UUIDs are set further below
+		cache->Store(entry.Name, std::move(cacheEntry));
+	}
 
-				currPos = instStart + module.first.size();
+	return 0;
+}
 
-			} while (currPos < moduleEnd);
+// Largest fault site width, i.e. width of GlobalFiSignal
+size_t RtlFile::LargestWidthGet(const moduleTable_t &modules)
+{
+#if FI_SINGLE_BIT
+	return 16;
+#else // !FI_SINGLE_BIT
+	size_t largestWidth = 0;
+	for(const auto &module: modules.Modules)
+	{
+		for(const auto &signal: module.FiSignal)
+		{
+			if(largestWidth < signal.Width)
+			{
+				largestWidth = signal.Width;
+			}
 		}
+	}
 
-		// Prepare next round
-		filePos = moduleEnd;
+	nfiDebug("Largest signal: %lu\n", largestWidth);
 
-	} while(filePos < Content_ + Size_);
+	return largestWidth;
+#endif // !FI_SINGLE_BIT
+}
 
-	const int hierarchyDepth = HierarchyDepthGet(modules, TopModule_);
-	if(0 >= hierarchyDepth)
+int RtlFile::IndexCreate()
+{
+	if(nullptr == Content_)
 	{
-		nfiError("HierarchyDepthGet failed\n");
+		nfiError("Nullptr\n");
 		return -1;
 	}
 
-	nfiDebug("hierarchyDepth = %i\n", hierarchyDepth);
+	if(!StructureDone_ && Structure_.Create(Content_, Size_))
+	{
+		nfiError("StructuralIndex::Create failed\n");
+		return -1;
+	}
 
-	// TODO: This is dirty
-	// clear instances from modules...will be filled again below with UUIDs
-	for(auto &module : modules)
+	if(CommentIndexCreate())
 	{
-		module.second.InstanceUuids.clear();
+		nfiError("CommentIndexCreate failed\n");
+		return -1;
 	}
 
-	// Add fiEnable to each module's input and corruption signal to all assignments
-	std::map<const char *, diff_t> diff; // <beginning of replace, replacement>
-	filePos = Content_;
-	do {
-		nfiDebug("Find next module\n");
-		std::string moduleName;
-		const char * moduleStart;
-		const char * moduleEnd;
-		const int modFindRet = ModuleFind(
-				&moduleName, &moduleStart, &moduleEnd,
-				filePos, Size_ - (filePos - Content_));
+	// Locate all modules once, later passes reuse the index
+	if(ModuleIndexCreate())
+	{
+		nfiError("ModuleIndexCreate failed\n");
+		return -1;
+	}
 
-		if(0 > modFindRet)
+	return 0;
+}
+
+// Key of each module covers everything its instrumented text depends on
+void RtlFile::KeysCreate(fiMode_t fiMode, const FiCache * cache)
+{
+	Keys_.resize(ModuleIndex_.size());
+	Cached_.assign(ModuleIndex_.size(), nullptr);
+	Stale_.assign(ModuleIndex_.size(), nullptr);
+
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
+	{
+		const moduleIndex_t &entry = ModuleIndex_[index];
+		const bool moduleIsTop = (entry.Name == TopModule_);
+
+		uint64_t key = FiCache::Hash(Content_ + entry.Start, entry.End - entry.Start);
+		key = FiCache::Hash(TopModule_.c_str(), TopModule_.size() + 1, key); // incl. '\0' as separator
+		key = FiCache::Hash(&fiMode, sizeof(fiMode), key);
+		key = FiCache::Hash(&moduleIsTop, sizeof(moduleIsTop), key);
+		uint64_t widthsHash;
+		if(nullptr != Json_ && Json_->WidthsHash(entry.Name, &widthsHash))
 		{
-			nfiError("moduleFind failed\n");
-			return -1;
+			// Widths of the JSON override the declarations, modules it lacks keep the key of runs without
+			key = FiCache::Hash(&widthsHash, sizeof(widthsHash), key);
 		}
-		else if(0 == modFindRet)
+		Keys_[index] = key;
+
+		if(nullptr != cache)
 		{
-			break;
+			Cached_[index] = cache->Find(entry.Name, key);
+			Stale_[index] = ((nullptr == Cached_[index]) && (cache->Top() == TopModule_)) ? cache->Find(entry.Name) : nullptr;
 		}
+	}
+}
 
-		if(200 < moduleName.size())
+// Adds the UUIDs cached modules keep to uuids
+void RtlFile::UuidsCachedGet(std::unordered_set<size_t> * uuids, const moduleTable_t &modules) const
+{
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
+	{
+		if((nullptr == Cached_[index]) || !modules.Modules[ModuleIndex_[index].Id].Reachable)
 		{
-			nfiError("Module name longer than 200 chars: %.200s\n", moduleName.c_str());
-			return -1;
+			continue;
 		}
 
-		nfiDebug("\tFound module %s\n", moduleName.c_str());
-
-		nfiDebug("Insert FI\n");
-
-		const bool moduleIsTop = (moduleName == TopModule_);
-
-		const std::string fiPrefix = moduleIsTop ? "" : TopModule_ + ".";
-
-		if(ModuleFi(moduleIsTop, fiPrefix, fiMode, &modules[moduleName], &diff, moduleStart, moduleEnd))
+		for(const auto &site: Cached_[index]->Sites)
 		{
-			nfiError("moduleFi failed\n");
-			return -1;
+			uuids->insert(site.UUID);
 		}
 
-		// Prepare next round
-		filePos = moduleEnd;
-
-	} while(filePos < Content_ + Size_);
+		for(const auto &instance: Instances_[index])
+		{
+			if(ModuleIdNone_ != instance.Module)
+			{
+				uuids->insert(instance.UUID);
+			}
+		}
+	}
+}
 
-	// Apply Diff
-	if(DiffApply(diff))
+// A changed module keeps the UUIDs of its earlier version if it has as many fault sites and the same instances,
+// and no module in uuids has them, i.e. it is numbered as without cache. Else Stale_ is reset for it.
+// The UUIDs kept are added to uuids, the instances get theirs. Returns the number of modules keeping them.
+size_t RtlFile::UuidsStaleKeep(std::unordered_set<size_t> * uuids, const moduleTable_t &modules)
+{
+	size_t keptCnt = 0;
+	std::vector<size_t> kept;
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
 	{
-		nfiError("DiffApply failed\n");
-		return -1;
-	}
+		const FiCache::entry_t * const stale = Stale_[index];
+		Stale_[index] = nullptr;
+
+		std::vector<instance_t> &instances = Instances_[index];
+		if((nullptr == stale) || !modules.Modules[ModuleIndex_[index].Id].Reachable ||
+				(stale->Sites.size() != ModuleIndex_[index].AssignmentsCnt) || (stale->Instances.size() != instances.size()))
+		{
+			continue;
+		}
 
-	diff.clear();
+		kept.clear();
+		bool keep = true;
+		for(size_t nr = 0; keep && (nr < stale->Sites.size()); nr++)
+		{
+			keep = (stale->Sites[nr].UUID == stale->Sites[0].UUID + nr);
+			kept.push_back(stale->Sites[nr].UUID);
+		}
 
-#if FI_SINGLE_BIT
-	const size_t largestWidth = 16;
-#else // !FI_SINGLE_BIT
-	// Get largest fi signal
-	size_t largestWidth = 0;
-	for(const auto &module: modules)
-	{
-		for(const auto &signal: module.second.FiSignal)
+		for(size_t nr = 0; keep && (nr < instances.size()); nr++)
 		{
-			if(largestWidth < signal.Width)
+			const FiCache::instance_t &instance = stale->Instances[nr];
+			keep = (instance.Type == instances[nr].Type) && ((0 != instance.UUID) == (ModuleIdNone_ != instances[nr].Module));
+			if(0 != instance.UUID)
 			{
-				largestWidth = signal.Width;
+				kept.push_back(instance.UUID);
 			}
 		}
-	}
-
-	nfiDebug("Largest signal: %lu\n", largestWidth);
-#endif // FI_SINGLE_BIT
 
-	// Associate UUID to each module instance and set fiEnable input
-	filePos = Content_;
-	do {
-		std::string moduleName;
-		const char * moduleStart;
-		const char * moduleEnd;
-		const int modFindRet = ModuleFind(
-				&moduleName, &moduleStart, &moduleEnd,
-				filePos, Size_ - (filePos - Content_));
+		std::sort(kept.begin(), kept.end());
+		keep = keep && (kept.end() == std::adjacent_find(kept.begin(), kept.end()));
+		for(size_t nr = 0; keep && (nr < kept.size()); nr++)
+		{
+			keep = (UuidFirst_ <= kept[nr]) && (0 == uuids->count(kept[nr]));
+		}
 
-		if(0 > modFindRet)
+		if(!keep)
 		{
-			nfiError("moduleFind failed\n");
-			return -1;
+			continue;
 		}
-		else if(0 == modFindRet)
+
+		uuids->insert(kept.begin(), kept.end());
+		for(size_t nr = 0; nr < instances.size(); nr++)
 		{
-			break;
+			instances[nr].UUID = stale->Instances[nr].UUID;
 		}
 
-		nfiDebug("Module declaration %s\n", moduleName.c_str());
-		auto modIt = modules.find(moduleName);
-		if(modules.end() == modIt)
+		Stale_[index] = stale;
+		keptCnt++;
+	}
+
+	return keptCnt;
+}
+
+// Associates a UUID to each module instance, sets its fiEnable input and adds the global inputs to top
+// The edits are added to diff, to be applied by the caller
+int RtlFile::InstancesWire(diffList_t * diff, moduleTable_t * modules, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext)
+{
+	for(size_t index = 0; index < ModuleIndex_.size(); index++)
+	{
+		const moduleIndex_t &entry = ModuleIndex_[index];
+
+		nfiDebug("Module declaration %s\n", entry.Name.c_str());
+
+		if(!modules->Modules[entry.Id].Reachable)
 		{
-			nfiError("No such module in list\n");
-			return -1;
+			continue;
 		}
 
-		if(ModuleInstancesHandle(modIt, &modules, &diff, moduleStart, moduleEnd, TopModule_, hierarchyDepth))
+		if(ModuleInstancesHandle(modules, entry.Id, Instances_[index], diff, TopModule_, hierarchyDepth, uuidNext))
 		{
 			nfiError("ModuleInstancesHandle failed\n");
 			return -1;
 		}
 
 		// If it's top module, add global inputs
-		if(modIt->first == TopModule_)
+		if(modules->Top == entry.Id)
 		{
-			if(GlobalSignalsToTopAdd(&diff, moduleStart, moduleEnd, largestWidth, hierarchyDepth))
+			if(GlobalSignalsToTopAdd(diff, Statements_[entry.StatementsStart], largestWidth, hierarchyDepth))
 			{
 				nfiError("GlobalSignalsToTopAdd failed\n");
 				return -1;
 			}
 		}
+	}
 
-		// Prepare next round
-		filePos = moduleEnd;
+	return 0;
+}
 
-	} while(filePos < Content_ + Size_);
+size_t RtlFile::ModuleBeginGet(const moduleIndex_t &entry) const
+{
+	// "module" keyword directly before the name
+	const size_t keywordNr = Structure_.CountBefore(StructuralIndex::STRUCT_MODULE, entry.Start);
+	size_t begin = Structure_.Positions(StructuralIndex::STRUCT_MODULE)[keywordNr - 1];
 
-	// Apply Diff
-	if(DiffApply(diff))
+	while(true)
 	{
-		nfiError("DiffApply failed\n");
-		return -1;
-	}
+		size_t pos = begin;
+		while((0 < pos) && isWhiteSpace(Content_[pos - 1]))
+		{
+			pos--;
+		}
+
+		// Attribute ending right before, i.e. the last comment region starting before pos
+		auto it = std::upper_bound(CommentIndex_.begin(), CommentIndex_.end(), pos,
+				[](size_t off, const std::pair<size_t, size_t> &region) { return off <= region.first; });
+		if((CommentIndex_.begin() == it) || ((it - 1)->second != pos) || ('(' != Content_[(it - 1)->first]))
+		{
+			return pos;
+		}
 
-	diff.clear();
+		begin = (it - 1)->first;
+	}
+}
 
-	// Create library with module hierarchy etc.
-	if(LibraryCreate(modules, TopModule_))
+// Removes modules not reachable from the top module, with their attributes
+void RtlFile::UnreachableDrop(diffList_t * diff, const moduleTable_t &modules) const
+{
+	const char * dropEnd = nullptr; // of the last removal
+	for(const auto &entry: ModuleIndex_)
 	{
-		nfiError("libraryCreate failed\n");
-		return -1;
-	}
+		if(modules.Modules[entry.Id].Reachable)
+		{
+			continue;
+		}
 
+		// Modules following each other are removed at once, as edits must not touch
+		const char * const begin = Content_ + ModuleBeginGet(entry);
+		if(begin == dropEnd)
+		{
+			diff->Edits.back().End = Content_ + entry.End;
+		}
+		else
+		{
+			diff->Edits.push_back({begin, Content_ + entry.End, std::string_view()});
+		}
 
-	return 0;
+		dropEnd = Content_ + entry.End;
+	}
 }
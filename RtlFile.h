@@ -21,10 +21,24 @@
 #ifndef RTLFILE_H_
 #define RTLFILE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #include <string>
-#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "Compression.h"
+#include "FiCache.h"
+#include "Profiler.h"
+#include "StructuralIndex.h"
+#include "TextArena.h"
+
+class YosysJson;
+
 class RtlFile {
 public:
 	RtlFile();
@@ -36,28 +50,160 @@ public:
 
 	int Get(const char * fileName, const std::string &topModule);
 
+	// Works on content owned by the caller, e.g. one window of a file too large to load at once
+	// Unless last, content may end within a module or comment, of which only complete modules are indexed
+	void WindowSet(const std::string &name, const std::string &topModule, const char * content, size_t size, bool last);
+
 	typedef enum {
 		FI_MODE_STUCK_HIGH,
 		FI_MODE_STUCK_LOW,
 		FI_MODE_FLIP
 	} fiMode_t;
 
-	int FiSignalsCreate(fiMode_t fiMode);
+	// Written to Output() if set, else the file itself is replaced
 	int WriteBack() const;
 
+	const std::string &Name() const { return Name_; }
+
+	// "-" for stdout, as a file name for stdin
+	static constexpr char StdioName[] = "-";
+
+	void OutputSet(const std::string &output) { Output_ = output; }
+	const std::string &Output() const { return Output_; }
+
+	// Where input goes for the output argument: empty writes input back, a directory takes a file
+	// of the same name, else output is the file itself
+	static std::string OutputName(const std::string &output, const std::string &input);
+	bool Edited() const { return !Pieces_.empty(); }
+
+	// Widths of the nets of modules found in json are taken from there instead of the declarations
+	void YosysJsonSet(const YosysJson * json) { Json_ = json; }
+
+	// Escaped identifiers name the same net as plain ones, e.g. "\in" and "in", this is how Yosys' JSON names both
+	static std::string_view NetNameNormalize(std::string_view name) { return (!name.empty() && ('\\' == name[0])) ? name.substr(1) : name; }
+
 private:
+	friend class FiCache; // saves the cache like the netlists
+	friend class RtlDesign; // instruments the modules of all files of a design
+	friend class RtlStream; // instruments a design window by window
+	friend class YosysJson; // provides declarations
+
 	std::string Name_;
-	char * Content_ = nullptr;
+	std::string Output_; // empty if written back to Name_
+	const char * Content_ = nullptr; // not '\0' terminated, always use Size_
 	size_t Size_ = 0;
 
+	void * Mapping_ = nullptr; // read-only mapping of the input file
+	size_t MappingSize_ = 0;
+	char * Buffer_ = nullptr; // owned content if the input could not be mapped
+	bool Partial_ = false; // content is a window that may end within a module
+	Compression::type_t Compression_ = Compression::COMPRESSION_NONE; // of the file, kept when writing back
+
+	int FileRead(int fd);
+	void ContentRelease();
+
 	std::string TopModule_;
+	const YosysJson * Json_ = nullptr;
 
+	// Replaces [Start, End) of the original Content_
 	typedef struct {
-		std::string Replacement;
+		const char * Start;
 		const char * End;
+		std::string_view Replacement; // in Text of the diff list
 	} diff_t;
 
-	int DiffApply(std::map<const char *, diff_t> &diff);
+	// Edits of one round, appended in any order, sorted once by DiffApply
+	typedef struct {
+		std::vector<diff_t> Edits;
+		TextArena Text;
+	} diffList_t;
+
+	int DiffApply(diffList_t &diff);
+
+	// Bytes the content grows by once diff is applied, also if its text is only measured
+	static ptrdiff_t DiffGrowthGet(const diffList_t &diff);
+
+	// Edited content: spans of the original Content_ and replacements, in order
+	typedef struct {
+		const char * Start;
+		size_t Size;
+		bool Original; // i.e. points into Content_
+	} piece_t;
+
+	std::vector<piece_t> Pieces_;
+	TextArena Replacements_; // storage of replacement pieces, adopted from the applied diffs
+
+	static int PiecesWrite(int fd, const std::vector<piece_t> &pieces);
+	static int PiecesWrite(Compressor * compressor, const std::vector<piece_t> &pieces);
+
+	// Output is written to a temporary file next to name, or the file a symlink name points to, which replaces it once complete
+	static int TmpCreate(std::string * tmpName, const std::string &name);
+	static int TmpCommit(int fd, const std::string &tmpName, const std::string &name);
+
+	// Regular files and new ones are written via TmpCreate, stdout and others, e.g. FIFOs, directly
+	// tmpName is left empty if name is written directly
+	static int OutputOpen(std::string * tmpName, const std::string &name);
+	static int OutputCommit(int fd, const std::string &tmpName, const std::string &name);
+	static void OutputAbort(int fd, const std::string &tmpName);
+
+	typedef enum {
+			FI_NEEDLE_ASSIGN,
+			FI_NEEDLE_ASSIGN_NON_BLOCKIN,
+			FI_NEEDLE_NROF
+		} fiNeedle_t;
+
+	static constexpr char fiNeedles[FI_NEEDLE_NROF][8] = {"assign ", "<="};
+
+	typedef uint32_t moduleId_t; // index into moduleTable_t::Modules
+	static constexpr moduleId_t ModuleIdNone_ = UINT32_MAX;
+
+	// Module locations as offsets into the original Content_
+	typedef struct {
+		std::string Name;
+		size_t Start; // after module name
+		size_t End; // after "endmodule"
+		size_t PortListEnd; // at ");" closing the port list
+		size_t Line;
+		size_t StatementsStart; // first statement in Statements_
+		size_t StatementsCnt;
+		size_t AssignmentsCnt; // i.e. fault sites
+		moduleId_t Id; // in the design's module table
+	} moduleIndex_t;
+
+	std::vector<moduleIndex_t> ModuleIndex_;
+
+	// Statements all later phases work on, found once per module
+	typedef enum {
+		STATEMENT_PORT_LIST,
+		STATEMENT_DECLARATION,
+		STATEMENT_ASSIGN, // continuous assignment
+		STATEMENT_NON_BLOCKING, // non-blocking assignment
+		STATEMENT_INSTANCE,
+		STATEMENT_NROF
+	} statementType_t;
+
+	typedef struct {
+		statementType_t Type;
+		const char * Start; // module name / type keyword / target signal / instantiated module
+		const char * NameEnd; // one after the above
+		const char * Equal; // '=' of assignments, else nullptr
+		const char * End; // at terminating ';'
+	} statement_t;
+
+	std::vector<statement_t> Statements_; // statements of all modules, in module index and text order
+
+	int IndexCreate();
+	int StatementsCreate(Profiler * profiler = nullptr); // records a scope per module
+	int ModuleStatementsCreate(moduleIndex_t &entry);
+	void ChunkClassify(const char * start, const char * semiColon);
+	int AssignmentStatementCreate(fiNeedle_t needleNr, const char * needle, const char * moduleStart, const char * moduleEnd);
+
+	StructuralIndex Structure_;
+	bool StructureDone_ = false; // index was built while reading the file
+
+	const char * StructNext(StructuralIndex::structural_t type, const char * pos, const char * stop) const;
+
+	int ModuleIndexCreate();
 
 	typedef enum {
 		SIGNAL_TYPE_WIRE,
@@ -73,70 +219,156 @@ private:
 
 	typedef struct {
 		signalType_t Type;
-		std::string Name;
+		std::string_view Target; // assigned signal(s) in Content_, e.g. "{a, b}", empty if taken from the cache
 		size_t Width;
 		size_t ElemCnt; // i.e. array elements
 		size_t UUID;
+		size_t SiteStart; // offset in Content_ of corrupted expression, i.e. after '='
+		size_t SiteEnd; // offset in Content_ of ';' ending the corrupted expression
 	} signal_t;
 
 	static constexpr char GlobalFiSignal_[] = "GlobalFiSignal";
 	static constexpr char GlobalFiNumber_[] = "GlobalFiNumber";
 	static constexpr char GlobalFiModInstNumber_[] = "GlobalFiModInstNr";
 	static constexpr size_t GlobalFiModInstNumberTop_ = 1;
+
+	static constexpr size_t UuidFirst_ = GlobalFiModInstNumberTop_ + 1; // first UUID of fault sites and instances
 	static constexpr char FiEnableStr[] = "fiEnable";
 
+	// Bytes CorruptionRender adds to an expression at most, without the fiPrefix used twice
+	static constexpr size_t CorruptionOverhead_ = 192;
+
 	static constexpr char FiSignalsLibraryNameAppend_[] = "FiSignals.cpp";
 
 	typedef struct {
-		std::string Name;
+		std::string_view Name; // points into moduleTable_t::NamePool
 		std::vector<signal_t> FiSignal;
-		std::vector<std::pair<void *, size_t>> InstanceUuids; // <module_t * instanceOfModulePointedTo, uuid>
+		size_t EdgesStart; // first instance edge of this module
+		size_t EdgesCnt; // only instances of netlist modules
+		bool Reachable; // instantiated below the top module or the top itself, others are not instrumented
+
+		// Of the expanded instance tree below and including this module, set by HierarchyAnalyze
+		size_t SubtreeDepth; // levels
+		size_t SubtreeInstances; // module instances
+		size_t SubtreeBits; // fault bits, i.e. what the runtime picks faults from
 	} module_t;
 
-	static int ModuleFind(std::string * name, const char ** start, const char ** end, const char * pFile, size_t nFile);
+	// All modules of the design, ordered by name, i.e. in library order.
+	// Names are only looked up when resolving instances, everything after works on ids.
+	typedef struct {
+		std::string NamePool; // all module names, back to back
+		std::vector<module_t> Modules; // indexed by moduleId_t
+		std::vector<moduleId_t> EdgeModules; // instantiated module of each instance edge, grouped by module
+		std::vector<size_t> EdgeUuids; // UUID of each instance edge
+		std::unordered_map<std::string_view, moduleId_t> Ids; // keys point into NamePool
+		moduleId_t Top;
+	} moduleTable_t;
+
+	// Instance statement, resolved once for hierarchy and fiEnable wiring
+	typedef struct {
+		moduleId_t Module; // instantiated module, ModuleIdNone_ if not part of the netlist
+		std::string_view Type; // name of instantiated module
+		const char * InputsEnd; // where fiEnable is connected
+		size_t UUID; // 0 until assigned, unless taken from the cache
+	} instance_t;
+
+	std::vector<std::vector<instance_t>> Instances_; // per module index entry
+
+	int InstancesResolve(const moduleTable_t &modules);
+	static const char * InputsEndGet(const statement_t &instance);
+	int InstancesWire(diffList_t * diff, moduleTable_t * modules, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext);
 
-	static int ModuleFi(
+	// Start of the declaration of entry, i.e. of its attributes and the white space before them
+	size_t ModuleBeginGet(const moduleIndex_t &entry) const;
+	void UnreachableDrop(diffList_t * diff, const moduleTable_t &modules) const;
+
+	// Per module index entry, everything the instrumented text depends on and the matching cache entry
+	std::vector<uint64_t> Keys_;
+	std::vector<const FiCache::entry_t *> Cached_; // nullptr if not cached
+	std::vector<const FiCache::entry_t *> Stale_; // earlier version of a changed module, nullptr if there's none
+
+	void KeysCreate(fiMode_t fiMode, const FiCache * cache);
+	void UuidsCachedGet(std::unordered_set<size_t> * uuids, const moduleTable_t &modules) const;
+	size_t UuidsStaleKeep(std::unordered_set<size_t> * uuids, const moduleTable_t &modules);
+	int CacheUpdate(FiCache * cache, const moduleTable_t &modules) const;
+
+	int ModuleFind(std::string * name, const char ** start, const char ** end, const char * pFile, size_t nFile) const;
+	const char * PortListEndGet(const char * start, const char * stop) const;
+
+	// diff may be nullptr to only collect the fault sites of module
+	int ModuleFi(
 			bool isTop, const std::string &fiPrefix,
 			fiMode_t fiMode,
-			module_t * module, std::map<const char *, diff_t> * diff,
-			const char * start, const char * stop);
+			module_t * module, diffList_t * diff,
+			const moduleIndex_t &entry, size_t uuidBase) const;
+
+	int ModuleFiCached(
+			bool isTop, const std::string &fiPrefix,
+			fiMode_t fiMode,
+			module_t * module, diffList_t * diff,
+			const moduleIndex_t &entry, const FiCache::entry_t &cached) const;
+
+	int ModuleFiRun(size_t index, fiMode_t fiMode, module_t * module, size_t uuidBase, diffList_t * diff) const;
+
+	// Module instrumented by ModuleFi, to be replayed on modules whose body is the same but for the name
+	typedef struct {
+		const char * Content; // of its file
+		size_t Start; // of the module body, i.e. moduleIndex_t::Start
+		const module_t * Module; // with the fault sites found
+		size_t UuidBase;
+	} replay_t;
+
+	replay_t ReplayGet(size_t index, const module_t * module, size_t uuidBase) const { return {Content_, ModuleIndex_[index].Start, module, uuidBase}; }
+
+	// Whether module index has the same body as module otherIndex of other, i.e. the same but for the name
+	bool BodyEqual(size_t index, const RtlFile &other, size_t otherIndex) const;
+
+	// Renders the sites of replay at the same positions of module index, with UUIDs following uuidBase
+	int ModuleFiReplay(size_t index, fiMode_t fiMode, module_t * module, size_t uuidBase, diffList_t * diff, const replay_t &replay) const;
 
 	static int ModuleInstancesHandle(
-			std::map<std::string, module_t>::iterator &currentModule,
-			std::map<std::string, module_t> * modules, std::map<const char *, diff_t> * diff,
-			const char * moduleStart, const char * moduleEnd,
+			moduleTable_t * modules, moduleId_t id,
+			std::vector<instance_t> &instances, diffList_t * diff,
 			const std::string &topModule,
-			size_t hierarchyDepth);
+			size_t hierarchyDepth, size_t * uuidNext);
 
-	static constexpr const char * blockCommentStartStr[] = {"(*", "/*"};
+	static constexpr const char * blockCommentEndStr[] = {"*)", "*/"}; // attribute, block comment
 
-	static constexpr const char * blockCommentEndStr[] = {"*)", "*/"};
+	std::vector<std::pair<size_t, size_t>> CommentIndex_; // <start, end> offsets of comments and attributes, sorted
 
-	static bool PosInsideComment(const char * pos, const char * start, const char * end);
-	static const char * SignalDeclarationGet(const std::string &signalName, const char * inModuleStart);
-	static int SubSignalWidthGet(const std::string &inSubSignal, const char * inModuleStart);
-	static int SignalDeclarationParse(signal_t * signal, const char * declaration);
-	static signalType_t TypeGet(const char ** declStart, const char * in, const char * inModuleStart);
+	int CommentIndexCreate();
+	bool PosInsideComment(const char * pos) const;
+	const char * CommentSkip(const char * pos) const;
+	const char * SpaceSkip(const char * pos, const char * stop) const;
 
-	static int FiEnableInputAdd(std::map<const char *, diff_t> * diff, const char * start, const char * stop);
-	static int GlobalSignalsToTopAdd(std::map<const char *, diff_t> * diff, const char * start, const char * stop, size_t fiSignalWidth, size_t hierarchyDepth);
+	typedef struct {
+		signalType_t Type;
+		size_t Width;
+		size_t ElemCnt; // i.e. array elements
+	} declaration_t;
 
-	typedef enum {
-			FI_NEEDLE_ASSIGN,
-			FI_NEEDLE_ASSIGN_NON_BLOCKIN,
-			FI_NEEDLE_NROF
-		} fiNeedle_t;
+	typedef std::unordered_map<std::string_view, declaration_t> declarations_t; // <normalized signal name, declaration>
 
-	static constexpr char fiNeedles[FI_NEEDLE_NROF][8] = {"assign ", "<="};
+	static signalType_t KeywordTypeGet(const char * start, const char * end);
+	int DeclarationsCreate(declarations_t * declarations, const moduleIndex_t &entry) const;
+	const char * DeclarationParse(declarations_t * declarations, signalType_t type, const char * pos, const char * stop) const;
+	static int SubSignalWidthGet(std::string_view inSubSignal, const declarations_t &declarations);
+
+	static int FiEnableInputAdd(diffList_t * diff, const statement_t &portList);
+	static int GlobalSignalsToTopAdd(diffList_t * diff, const statement_t &portList, size_t fiSignalWidth, size_t hierarchyDepth);
 
-	static const char * NextNeedle(size_t * needleNr, const char * pHaystack, size_t nHaystack);
-	static int NeedleCorrupt(fiMode_t fiMode, module_t * module, std::map<const char *, diff_t> * diff,
-			const std::string &fiPrefix,
-			const char * moduleStart, const char * moduleEnd, const char * needle, fiNeedle_t needleNr);
+	const char * NextNeedle(size_t * needleNr, const char * pHaystack, size_t nHaystack) const;
+	int NeedleCorrupt(fiMode_t fiMode, module_t * module, diffList_t * diff,
+			const std::string &fiPrefix, const declarations_t &declarations, const statement_t &statement, size_t uuid) const;
+	static int CorruptionRender(diffList_t * diff, fiMode_t fiMode, const std::string &fiPrefix, const signal_t &fiSignal,
+			const char * equal, const char * semiColon);
 
-	static int LibraryCreate(const std::map<std::string, module_t> &modules, const std::string &topName);
-	static int MapOffsetsCalculate(std::map<std::string, size_t> * offsets, const std::map<std::string, module_t> &modules);
-	static int HierarchyDepthGet(const std::map<std::string, module_t> &modules, const std::string &topName);
+	// Written to libraryName, "<topName>FiSignals.cpp" if empty
+	static int LibraryCreate(const moduleTable_t &modules, const std::string &topName, const std::string &libraryName);
+	static void ReachableMark(moduleTable_t * modules);
+	static int HierarchyAnalyze(moduleTable_t * modules);
+	static int HierarchyPrint(FILE * file, const moduleTable_t &modules); // of the top module
+	static size_t LargestWidthGet(const moduleTable_t &modules);
 };
 
 #endif /* RTLFILE_H_ */
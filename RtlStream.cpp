@@ -0,0 +1,636 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "common.h"
+
+#include "ParallelFor.h"
+#include "RtlDesign.h"
+#include "RtlStream.h"
+
+void RtlStream::OutputSet(const std::string &output, const std::string &library)
+{
+	Output_ = output;
+	Library_ = library;
+}
+
+int RtlStream::Run(const std::vector<std::string> &paths, const std::string &topModule, RtlFile::fiMode_t fiMode,
+		size_t windowSize, size_t jobs)
+{
+	if(!Files_.empty())
+	{
+		nfiError("RtlStream already contains files\n");
+		return -1;
+	}
+
+	if(0 == windowSize)
+	{
+		nfiError("Window size must not be 0\n");
+		return -1;
+	}
+
+	std::vector<std::string> fileNames;
+	if(RtlDesign::PathsExpand(&fileNames, paths))
+	{
+		nfiError("PathsExpand failed\n");
+		return -1;
+	}
+
+	if(RtlDesign::OutputsCheck(fileNames, Output_))
+	{
+		nfiError("OutputsCheck failed\n");
+		return -1;
+	}
+
+	TopModule_ = topModule;
+	FiMode_ = fiMode;
+	Jobs_ = jobs;
+
+	Files_.resize(fileNames.size());
+	for(size_t file = 0; file < fileNames.size(); file++)
+	{
+		Files_[file].Name = fileNames[file];
+		Files_[file].Output = Output_.empty() ? "" : RtlFile::OutputName(Output_, fileNames[file]);
+	}
+
+	// Fault sites of a module get consecutive UUIDs in text order, modules in file order
+	Timer_.Start("Scan");
+	size_t uuidNext = RtlFile::UuidFirst_;
+	for(auto &file: Files_)
+	{
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, file.Name);
+
+		if(FileScan(&file, windowSize, &uuidNext))
+		{
+			nfiError("FileScan failed for %s\n", file.Name.c_str());
+			return -1;
+		}
+	}
+
+	Timer_.Start("ModulesResolve");
+	if(ModulesResolve())
+	{
+		nfiError("ModulesResolve failed\n");
+		return -1;
+	}
+
+	Timer_.Start("Hierarchy");
+	RtlFile::ReachableMark(&Modules_);
+	uuidNext = UnreachableUuidsRemove(uuidNext);
+
+	if(RtlFile::HierarchyAnalyze(&Modules_))
+	{
+		nfiError("HierarchyAnalyze failed\n");
+		return -1;
+	}
+
+	const size_t hierarchyDepth = Modules_.Modules[Modules_.Top].SubtreeDepth;
+
+	const size_t largestWidth = RtlFile::LargestWidthGet(Modules_);
+
+	// Instance UUIDs follow all fault sites, handed out in file order
+	Timer_.Start("Write");
+	for(const auto &file: Files_)
+	{
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryFile, file.Name);
+
+		if(FileWrite(file, hierarchyDepth, largestWidth, &uuidNext))
+		{
+			nfiError("FileWrite failed for %s\n", file.Name.c_str());
+			return -1;
+		}
+	}
+
+	Timer_.Start("LibraryCreate");
+	if(RtlFile::LibraryCreate(Modules_, TopModule_, Library_))
+	{
+		nfiError("libraryCreate failed\n");
+		return -1;
+	}
+
+	Timer_.Stop();
+
+	return 0;
+}
+
+size_t RtlStream::Size() const
+{
+	size_t size = 0;
+	for(const auto &file: Files_)
+	{
+		size += file.Size;
+	}
+
+	return size;
+}
+
+// Scans file window by window, each window ends after the last module complete within it
+int RtlStream::FileScan(file_t * file, size_t windowSize, size_t * uuidNext)
+{
+	if(0 == strcmp(file->Name.c_str(), RtlFile::StdioName))
+	{
+		nfiError("stdin can't be streamed, it would be read twice\n");
+		return -1;
+	}
+
+	const int fd = open(file->Name.c_str(), O_RDONLY);
+	if(0 > fd)
+	{
+		nfiError("failed to open file %s\n", file->Name.c_str());
+		return -1;
+	}
+
+	// Written files are read twice, so no pipes
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) || !S_ISREG(fileStat.st_mode) || (0 == fileStat.st_size))
+	{
+		nfiError("%s is no regular, non-empty file\n", file->Name.c_str());
+		close(fd);
+		return -1;
+	}
+
+	file->DiskSize = fileStat.st_size;
+	file->DiskModified = fileStat.st_mtim;
+
+	// Compressed files are decompressed on another thread while windows are scanned
+	Decompressor decompressor;
+	if(decompressor.Open(fd, file->Name.c_str()))
+	{
+		nfiError("Decompressor::Open failed for %s\n", file->Name.c_str());
+		close(fd);
+		return -1;
+	}
+
+	file->Compressed = decompressor.Type();
+
+	if(Buffer_.size() < windowSize)
+	{
+		Buffer_.resize(windowSize);
+	}
+
+	size_t start = 0; // offset of Buffer_ in the file
+	size_t filled = 0;
+	size_t lineBase = 0; // lines before start
+	while(true)
+	{
+		const size_t readSize = Buffer_.size() - filled;
+		const ssize_t readRet = decompressor.ReadFull(Buffer_.data() + filled, readSize);
+		if(0 > readRet)
+		{
+			nfiError("ReadFull failed on %s\n", file->Name.c_str());
+			close(fd);
+			return -1;
+		}
+
+		filled += readRet;
+
+		const bool last = (readSize > (size_t) readRet);
+		Window_.WindowSet(file->Name, TopModule_, Buffer_.data(), filled, last);
+		if(Window_.IndexCreate())
+		{
+			nfiError("IndexCreate failed for %s at offset %lu\n", file->Name.c_str(), start);
+			close(fd);
+			return -1;
+		}
+
+		// Module larger than the window
+		if(!last && Window_.ModuleIndex_.empty())
+		{
+			Buffer_.resize(2 * Buffer_.size());
+			continue;
+		}
+
+		// The last window takes the rest of the file, the others stop after their last module
+		const size_t size = last ? filled : Window_.ModuleIndex_.back().End;
+		if(WindowScan(file, start, size, lineBase, uuidNext))
+		{
+			nfiError("WindowScan failed for %s at offset %lu\n", file->Name.c_str(), start);
+			close(fd);
+			return -1;
+		}
+
+		if(last)
+		{
+			file->Size = start + filled;
+			break;
+		}
+
+		lineBase += Window_.Structure_.CountBefore(StructuralIndex::STRUCT_NEWLINE, size);
+
+		memmove(Buffer_.data(), Buffer_.data() + size, filled - size);
+		start += size;
+		filled -= size;
+	}
+
+	close(fd); // no write performed, so no need to check
+
+	return 0;
+}
+
+// Collects fault sites and instances of the modules of Window_, which starts at start of file
+int RtlStream::WindowScan(file_t * file, size_t start, size_t size, size_t lineBase, size_t * uuidNext)
+{
+	RtlFile &window = Window_;
+	const size_t modulesCnt = window.ModuleIndex_.size();
+
+	for(auto &entry: window.ModuleIndex_)
+	{
+		entry.Line += lineBase;
+	}
+
+	window.Cached_.assign(modulesCnt, nullptr);
+	if(window.StatementsCreate(Timer_.ProfilerGet()))
+	{
+		nfiError("StatementsCreate failed\n");
+		return -1;
+	}
+
+	// UUIDs are known up front, so modules may be scanned in any order
+	std::vector<size_t> uuidBases(modulesCnt);
+	for(size_t index = 0; index < modulesCnt; index++)
+	{
+		uuidBases[index] = *uuidNext;
+		*uuidNext += window.ModuleIndex_[index].AssignmentsCnt;
+	}
+
+	const size_t modulesStart = file->Modules.size();
+	file->Modules.resize(modulesStart + modulesCnt);
+
+	// Only the sites are collected, nothing is rendered yet
+	std::vector<int> rets(modulesCnt, 0);
+	parallelFor(modulesCnt, Jobs_, [&](size_t index) {
+		const RtlFile::moduleIndex_t &entry = window.ModuleIndex_[index];
+		Profiler::Scope scope(Timer_.ProfilerGet(), Profiler::CategoryModule, entry.Name);
+
+		RtlFile::module_t sites;
+		rets[index] = window.ModuleFiRun(index, FiMode_, &sites, uuidBases[index], nullptr);
+
+		// Targets point into the window
+		for(auto &signal: sites.FiSignal)
+		{
+			signal.Target = std::string_view();
+			signal.SiteStart += start;
+			signal.SiteEnd += start;
+		}
+
+		file->Modules[modulesStart + index].FiSignal = std::move(sites.FiSignal);
+	});
+
+	if(RtlDesign::RetsCheck(rets))
+	{
+		return -1;
+	}
+
+	for(size_t index = 0; index < modulesCnt; index++)
+	{
+		const RtlFile::moduleIndex_t &entry = window.ModuleIndex_[index];
+		module_t &module = file->Modules[modulesStart + index];
+
+		module.Name = entry.Name;
+		module.Begin = start + window.ModuleBeginGet(entry);
+		module.End = start + entry.End;
+		module.PortListEnd = start + entry.PortListEnd;
+		module.AssignmentsCnt = entry.AssignmentsCnt;
+		module.Id = RtlFile::ModuleIdNone_;
+
+		const RtlFile::statement_t * const statements = window.Statements_.data() + entry.StatementsStart;
+		for(size_t nr = 0; nr < entry.StatementsCnt; nr++)
+		{
+			const RtlFile::statement_t &statement = statements[nr];
+			if(RtlFile::STATEMENT_INSTANCE != statement.Type)
+			{
+				continue;
+			}
+
+			const size_t inputsEnd = start + (RtlFile::InputsEndGet(statement) - window.Content_);
+			const uint32_t typeNr = TypeIntern(std::string_view(statement.Start, statement.NameEnd - statement.Start));
+			module.Instances.push_back({inputsEnd, typeNr, RtlFile::ModuleIdNone_});
+		}
+	}
+
+	file->Windows.push_back({start, size, modulesStart, modulesCnt});
+
+	return 0;
+}
+
+// Sites of modules not reachable from the top are dropped, the following ones renumbered
+// as if those modules had not been scanned, returns the UUID following all sites
+size_t RtlStream::UnreachableUuidsRemove(size_t uuidNext)
+{
+	size_t removed = 0;
+	for(const auto &file: Files_)
+	{
+		for(const auto &module: file.Modules)
+		{
+			RtlFile::module_t &tableModule = Modules_.Modules[module.Id];
+			if(!tableModule.Reachable)
+			{
+				tableModule.FiSignal.clear();
+				removed += module.AssignmentsCnt;
+				continue;
+			}
+
+			for(auto &signal: tableModule.FiSignal)
+			{
+				signal.UUID -= removed;
+			}
+		}
+	}
+
+	return uuidNext - removed;
+}
+
+uint32_t RtlStream::TypeIntern(std::string_view type)
+{
+	const auto typeIt = TypeNrs_.find(type);
+	if(TypeNrs_.end() != typeIt)
+	{
+		return typeIt->second;
+	}
+
+	TypePool_.Append(type);
+	const std::string_view interned = TypePool_.Finish();
+
+	Types_.push_back(interned);
+	TypeNrs_[interned] = Types_.size() - 1;
+
+	return Types_.size() - 1;
+}
+
+// Builds the module table of all files, with the fault sites and instance edges of each module
+// Per module, instances of netlist modules are ordered by module name, then by position, as in RtlFile::InstancesResolve
+int RtlStream::ModulesResolve()
+{
+	std::vector<RtlDesign::moduleName_t> names;
+	for(auto &file: Files_)
+	{
+		for(auto &module: file.Modules)
+		{
+			names.push_back({module.Name, &module.Id, &file.Name});
+		}
+	}
+
+	if(RtlDesign::ModuleTableCreate(&Modules_, names, TopModule_))
+	{
+		nfiError("ModuleTableCreate failed\n");
+		return -1;
+	}
+
+	std::vector<RtlFile::moduleId_t> typeIds(Types_.size(), RtlFile::ModuleIdNone_);
+	for(size_t typeNr = 0; typeNr < Types_.size(); typeNr++)
+	{
+		const auto idIt = Modules_.Ids.find(Types_[typeNr]);
+		if(Modules_.Ids.end() != idIt)
+		{
+			typeIds[typeNr] = idIt->second;
+		}
+	}
+
+	for(auto &file: Files_)
+	{
+		for(auto &module: file.Modules)
+		{
+			// Instances of library cells are not wired
+			for(auto &instance: module.Instances)
+			{
+				instance.Module = typeIds[instance.TypeNr];
+			}
+
+			module.Instances.erase(std::remove_if(module.Instances.begin(), module.Instances.end(),
+					[](const instance_t &instance) { return RtlFile::ModuleIdNone_ == instance.Module; }),
+					module.Instances.end());
+			std::stable_sort(module.Instances.begin(), module.Instances.end(),
+					[](const instance_t &a, const instance_t &b) { return a.Module < b.Module; });
+
+			RtlFile::module_t &tableModule = Modules_.Modules[module.Id];
+			tableModule.FiSignal = std::move(module.FiSignal);
+			tableModule.EdgesCnt = module.Instances.size();
+		}
+	}
+
+	size_t edgesStart = 0;
+	for(auto &module: Modules_.Modules)
+	{
+		module.EdgesStart = edgesStart;
+		edgesStart += module.EdgesCnt;
+	}
+
+	Modules_.EdgeModules.resize(edgesStart);
+	Modules_.EdgeUuids.assign(edgesStart, 0);
+
+	for(const auto &file: Files_)
+	{
+		for(const auto &module: file.Modules)
+		{
+			const size_t edgesStart = Modules_.Modules[module.Id].EdgesStart;
+			for(size_t inst = 0; inst < module.Instances.size(); inst++)
+			{
+				Modules_.EdgeModules[edgesStart + inst] = module.Instances[inst].Module;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Writes the instrumented file next to its output, then replaces that
+// Files without modules are not rewritten, unless written to another output
+int RtlStream::FileWrite(const file_t &file, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext)
+{
+	if(file.Modules.empty() && file.Output.empty())
+	{
+		nfiDebug("%s unchanged, not written\n", file.Name.c_str());
+		return 0;
+	}
+
+	const int fd = open(file.Name.c_str(), O_RDONLY);
+	if(0 > fd)
+	{
+		nfiError("failed to open file %s\n", file.Name.c_str());
+		return -1;
+	}
+
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) || (file.DiskSize != (size_t) fileStat.st_size) ||
+			(file.DiskModified.tv_sec != fileStat.st_mtim.tv_sec) || (file.DiskModified.tv_nsec != fileStat.st_mtim.tv_nsec))
+	{
+		nfiError("%s changed since it was scanned\n", file.Name.c_str());
+		close(fd);
+		return -1;
+	}
+
+	const std::string &output = file.Output.empty() ? file.Name : file.Output;
+	std::string tmpName;
+	const int outFd = RtlFile::OutputOpen(&tmpName, output);
+	if(0 > outFd)
+	{
+		nfiError("OutputOpen failed for %s\n", output.c_str());
+		close(fd);
+		return -1;
+	}
+
+	// Output is compressed like the input, on another thread
+	Decompressor decompressor;
+	Compressor compressor;
+	int ret = decompressor.Open(fd, file.Name.c_str()) || compressor.Open(outFd, file.Compressed, output.c_str());
+	if(0 == ret)
+	{
+		ret = WindowsWrite(&decompressor, &compressor, file, hierarchyDepth, largestWidth, uuidNext) || compressor.Close();
+	}
+
+	close(fd); // no write performed, so no need to check
+
+	if(ret)
+	{
+		nfiError("WindowsWrite failed for %s\n", file.Name.c_str());
+		RtlFile::OutputAbort(outFd, tmpName);
+		return -1;
+	}
+
+	return RtlFile::OutputCommit(outFd, tmpName, output);
+}
+
+// Reads, instruments and writes the windows of file one after the other
+int RtlStream::WindowsWrite(Decompressor * in, Compressor * out, const file_t &file, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext)
+{
+	for(const auto &window: file.Windows)
+	{
+		if(Buffer_.size() < window.Size)
+		{
+			Buffer_.resize(window.Size);
+		}
+
+		// Windows follow each other without gaps
+		if((ssize_t) window.Size != in->ReadFull(Buffer_.data(), window.Size))
+		{
+			nfiError("ReadFull failed at offset %lu\n", window.Start);
+			return -1;
+		}
+
+		Window_.WindowSet(file.Name, TopModule_, Buffer_.data(), window.Size, true);
+
+		RtlFile::diffList_t diff;
+		if(WindowRender(&diff, file, window, hierarchyDepth, largestWidth, uuidNext))
+		{
+			nfiError("WindowRender failed at offset %lu\n", window.Start);
+			return -1;
+		}
+
+		if(Window_.DiffApply(diff))
+		{
+			nfiError("DiffApply failed at offset %lu\n", window.Start);
+			return -1;
+		}
+
+		std::vector<RtlFile::piece_t> unedited;
+		const std::vector<RtlFile::piece_t> * pieces = &Window_.Pieces_;
+		if(Window_.Pieces_.empty())
+		{
+			unedited.push_back({Window_.Content_, Window_.Size_, true});
+			pieces = &unedited;
+		}
+
+		if(RtlFile::PiecesWrite(out, *pieces))
+		{
+			nfiError("PiecesWrite failed at offset %lu\n", window.Start);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Renders the edits of all modules of window from what the scan collected, nothing is parsed again
+int RtlStream::WindowRender(RtlFile::diffList_t * diff, const file_t &file, const window_t &window,
+		size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext)
+{
+	const char * const content = Window_.Content_;
+	const size_t start = window.Start; // offset of content in the file
+
+	std::vector<RtlFile::instance_t> instances;
+	size_t dropEnd = SIZE_MAX; // of the last removal
+	for(size_t nr = window.ModulesStart; nr < window.ModulesStart + window.ModulesCnt; nr++)
+	{
+		const module_t &module = file.Modules[nr];
+		if(!Modules_.Modules[module.Id].Reachable)
+		{
+			// As RtlFile::UnreachableDrop
+			if(UnreachableDrop_ && (module.Begin == dropEnd))
+			{
+				diff->Edits.back().End = content + (module.End - start);
+			}
+			else if(UnreachableDrop_)
+			{
+				diff->Edits.push_back({content + (module.Begin - start), content + (module.End - start), std::string_view()});
+			}
+
+			dropEnd = module.End;
+			continue;
+		}
+
+		const bool isTop = (Modules_.Top == module.Id);
+		const std::string fiPrefix = isTop ? "" : TopModule_ + ".";
+
+		// Edits only need the end of the port list
+		const char * const ioEnd = content + (module.PortListEnd - start);
+		const RtlFile::statement_t portList = {RtlFile::STATEMENT_PORT_LIST, nullptr, ioEnd, nullptr, ioEnd + 1};
+
+		if(!isTop && RtlFile::FiEnableInputAdd(diff, portList))
+		{
+			nfiError("FiEnableInputAdd failed for %s\n", module.Name.c_str());
+			return -1;
+		}
+
+		for(const auto &signal: Modules_.Modules[module.Id].FiSignal)
+		{
+			if(RtlFile::CorruptionRender(diff, FiMode_, fiPrefix, signal, content + (signal.SiteStart - start), content + (signal.SiteEnd - start)))
+			{
+				nfiError("CorruptionRender failed for %s\n", module.Name.c_str());
+				return -1;
+			}
+		}
+
+		instances.clear();
+		for(const auto &instance: module.Instances)
+		{
+			instances.push_back({instance.Module, Types_[instance.TypeNr], content + (instance.InputsEnd - start), 0});
+		}
+
+		if(RtlFile::ModuleInstancesHandle(&Modules_, module.Id, instances, diff, TopModule_, hierarchyDepth, uuidNext))
+		{
+			nfiError("ModuleInstancesHandle failed for %s\n", module.Name.c_str());
+			return -1;
+		}
+
+		if(isTop && RtlFile::GlobalSignalsToTopAdd(diff, portList, largestWidth, hierarchyDepth))
+		{
+			nfiError("GlobalSignalsToTopAdd failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef RTLSTREAM_H_
+#define RTLSTREAM_H_
+
+#include <stddef.h>
+#include <time.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Compression.h"
+#include "PhaseTimer.h"
+#include "RtlFile.h"
+#include "TextArena.h"
+
+// Instruments netlists too large to be loaded at once, window by window.
+// A scan of all files collects the fault sites and instances of each module, which is all
+// the hierarchy depth, the largest fault width and the UUIDs need. The write pass then renders
+// each window from these, so memory follows the largest window rather than the files.
+class RtlStream {
+public:
+	// As RtlDesign::OutputSet, to be called before Run
+	void OutputSet(const std::string &output, const std::string &library);
+
+	// As RtlDesign::UnreachableDropSet
+	void UnreachableDropSet(bool drop) { UnreachableDrop_ = drop; }
+
+	// As RtlDesign::YosysJsonSet
+	void YosysJsonSet(const YosysJson * json) { Window_.YosysJsonSet(json); }
+
+	// paths are files or directories, of which all *.v files are taken, stdin can't be read twice
+	// Windows hold windowSize bytes, or the largest module if that is larger
+	int Run(const std::vector<std::string> &paths, const std::string &topModule, RtlFile::fiMode_t fiMode,
+			size_t windowSize, size_t jobs = 1);
+
+	// Phases of Run
+	PhaseTimer &Timer() { return Timer_; }
+
+	size_t Size() const; // bytes of all files
+
+	// Depth, instances and fault bits of the expanded hierarchy, once instrumented
+	int HierarchyPrint(FILE * file) const { return RtlFile::HierarchyPrint(file, Modules_); }
+
+private:
+	// Part of a file, up to the end of its last complete module
+	typedef struct {
+		size_t Start; // offset in the file
+		size_t Size;
+		size_t ModulesStart; // first module of the window in file_t::Modules
+		size_t ModulesCnt;
+	} window_t;
+
+	typedef struct {
+		size_t InputsEnd; // offset in the file
+		uint32_t TypeNr; // in Types_
+		RtlFile::moduleId_t Module; // ModuleIdNone_ until resolved
+	} instance_t;
+
+	typedef struct {
+		std::string Name;
+		size_t Begin; // offset in the file, see RtlFile::ModuleBeginGet
+		size_t End; // offset in the file, after "endmodule"
+		size_t PortListEnd; // offset in the file
+		size_t AssignmentsCnt; // UUIDs taken by the scan
+		RtlFile::moduleId_t Id;
+		std::vector<RtlFile::signal_t> FiSignal; // sites are offsets in the file, moved to the module table once resolved
+		std::vector<instance_t> Instances; // in text order, only netlist modules in hierarchy order once resolved
+	} module_t;
+
+	typedef struct {
+		std::string Name;
+		std::string Output; // empty if written back
+		size_t Size; // decompressed
+		Compression::type_t Compressed; // kept when writing
+		size_t DiskSize; // with DiskModified, the file must not change between scan and write
+		struct timespec DiskModified;
+		std::vector<window_t> Windows;
+		std::vector<module_t> Modules; // in text order
+	} file_t;
+
+	std::vector<file_t> Files_; // in order of paths, UUIDs are handed out in this order
+	std::string TopModule_;
+	std::string Output_; // empty if written back
+	std::string Library_; // empty for the default name
+	bool UnreachableDrop_ = false;
+	RtlFile::fiMode_t FiMode_ = RtlFile::FI_MODE_FLIP;
+	size_t Jobs_ = 1;
+
+	RtlFile::moduleTable_t Modules_; // of all files
+
+	// Names of instantiated modules, library cells repeat a lot
+	TextArena TypePool_;
+	std::vector<std::string_view> Types_; // point into TypePool_
+	std::unordered_map<std::string_view, uint32_t> TypeNrs_;
+
+	RtlFile Window_; // window of the file being scanned or written
+	std::vector<char> Buffer_; // content of Window_, grows to the largest window
+
+	PhaseTimer Timer_;
+
+	int FileScan(file_t * file, size_t windowSize, size_t * uuidNext);
+	int WindowScan(file_t * file, size_t start, size_t size, size_t lineBase, size_t * uuidNext);
+	uint32_t TypeIntern(std::string_view type);
+	int ModulesResolve();
+	size_t UnreachableUuidsRemove(size_t uuidNext);
+	int FileWrite(const file_t &file, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext);
+	int WindowsWrite(Decompressor * in, Compressor * out, const file_t &file, size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext);
+	int WindowRender(RtlFile::diffList_t * diff, const file_t &file, const window_t &window,
+			size_t hierarchyDepth, size_t largestWidth, size_t * uuidNext);
+};
+
+#endif /* RTLSTREAM_H_ */
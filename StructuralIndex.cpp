@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif // __AVX2__
+
+#include "common.h"
+
+#include "StructuralIndex.h"
+
+// Keywords are only classified by their first two chars, the rest is verified
+static const char * const keywords[StructuralIndex::STRUCT_NROF] = {
+		nullptr,
+		"assign ",
+		"module ",
+		"endmodule",
+};
+
+void StructuralIndex::Verify(structural_t type, const char * content, size_t size, size_t pos)
+{
+	const char * keyword = keywords[type];
+	const size_t len = strlen(keyword);
+	if((pos + len <= size) && (0 == memcmp(content + pos, keyword, len)))
+	{
+		Positions_[type].push_back(pos);
+	}
+}
+
+void StructuralIndex::ScalarClassify(const char * content, size_t size, size_t start, size_t stop)
+{
+	for(size_t pos = start; pos < stop; pos++)
+	{
+		const char next = (pos + 1 < size) ? content[pos + 1] : '\0';
+
+		switch(content[pos])
+		{
+		case '<':
+			if('=' == next)
+			{
+				Positions_[STRUCT_NON_BLOCKING].push_back(pos);
+			}
+			break;
+
+		case 'a':
+			if('s' == next)
+			{
+				Verify(STRUCT_ASSIGN, content, size, pos);
+			}
+			break;
+
+		case 'm':
+			if('o' == next)
+			{
+				Verify(STRUCT_MODULE, content, size, pos);
+			}
+			break;
+
+		case 'e':
+			if('n' == next)
+			{
+				Verify(STRUCT_ENDMODULE, content, size, pos);
+			}
+			break;
+
+		case ';':
+			Positions_[STRUCT_SEMICOLON].push_back(pos);
+			break;
+
+		case '(':
+			if('*' == next)
+			{
+				Positions_[STRUCT_ATTRIBUTE].push_back(pos);
+			}
+			break;
+
+		case '/':
+			if('*' == next)
+			{
+				Positions_[STRUCT_BLOCK_COMMENT].push_back(pos);
+			}
+			else if('/' == next)
+			{
+				Positions_[STRUCT_LINE_COMMENT].push_back(pos);
+			}
+			break;
+
+		case '\n':
+			Positions_[STRUCT_NEWLINE].push_back(pos);
+			break;
+
+		case '"':
+			Positions_[STRUCT_QUOTE].push_back(pos);
+			break;
+
+		case '\\':
+			Positions_[STRUCT_BACKSLASH].push_back(pos);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+#if defined(__AVX2__)
+static inline uint64_t charMask(const __m256i &lo, const __m256i &hi, char c)
+{
+	const __m256i needle = _mm256_set1_epi8(c);
+	const uint32_t maskLo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle));
+	const uint32_t maskHi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle));
+
+	return ((uint64_t) maskHi << 32) | maskLo;
+}
+#endif // __AVX2__
+
+void StructuralIndex::Clear()
+{
+	for(auto &positions: Positions_)
+	{
+		positions.clear();
+	}
+
+	Indexed_ = 0;
+	Complete_ = false;
+}
+
+int StructuralIndex::Create(const char * content, size_t size)
+{
+	Clear();
+	Extend(content, size, true);
+
+	nfiDebug("Structural index: %lu needles, %lu modules, %lu lines\n",
+			Positions_[STRUCT_NON_BLOCKING].size() + Positions_[STRUCT_ASSIGN].size(),
+			Positions_[STRUCT_MODULE].size(), Positions_[STRUCT_NEWLINE].size());
+
+	return 0;
+}
+
+void StructuralIndex::Extend(const char * content, size_t size, bool last)
+{
+	if(Complete_)
+	{
+		Clear(); // content of a new round
+	}
+
+	// Keywords at the end may not be complete yet
+	const size_t stop = last ? size : ((Indexed_ + Lookahead_ < size) ? size - Lookahead_ : Indexed_);
+
+	Classify(content, size, Indexed_, stop);
+
+	Indexed_ = stop;
+	Complete_ = last;
+}
+
+// Classifies [start, stop) of content, positions up to size may be looked at
+void StructuralIndex::Classify(const char * content, size_t size, size_t start, size_t stop)
+{
+	size_t pos = start;
+
+#if defined(__AVX2__)
+	// Two char tokens compare each block with itself shifted by one, so the byte after the block must exist
+	for(; (pos + 64 <= stop) && (pos + 64 < size); pos += 64)
+	{
+		const __m256i curLo = _mm256_loadu_si256((const __m256i *) (content + pos));
+		const __m256i curHi = _mm256_loadu_si256((const __m256i *) (content + pos + 32));
+		const __m256i nextLo = _mm256_loadu_si256((const __m256i *) (content + pos + 1));
+		const __m256i nextHi = _mm256_loadu_si256((const __m256i *) (content + pos + 33));
+
+		const uint64_t nextStar = charMask(nextLo, nextHi, '*');
+		const uint64_t slash = charMask(curLo, curHi, '/');
+
+		uint64_t masks[STRUCT_NROF];
+		masks[STRUCT_NON_BLOCKING] = charMask(curLo, curHi, '<') & charMask(nextLo, nextHi, '=');
+		masks[STRUCT_ASSIGN] = charMask(curLo, curHi, 'a') & charMask(nextLo, nextHi, 's');
+		masks[STRUCT_MODULE] = charMask(curLo, curHi, 'm') & charMask(nextLo, nextHi, 'o');
+		masks[STRUCT_ENDMODULE] = charMask(curLo, curHi, 'e') & charMask(nextLo, nextHi, 'n');
+		masks[STRUCT_SEMICOLON] = charMask(curLo, curHi, ';');
+		masks[STRUCT_ATTRIBUTE] = charMask(curLo, curHi, '(') & nextStar;
+		masks[STRUCT_BLOCK_COMMENT] = slash & nextStar;
+		masks[STRUCT_LINE_COMMENT] = slash & charMask(nextLo, nextHi, '/');
+		masks[STRUCT_NEWLINE] = charMask(curLo, curHi, '\n');
+		masks[STRUCT_QUOTE] = charMask(curLo, curHi, '"');
+		masks[STRUCT_BACKSLASH] = charMask(curLo, curHi, '\\');
+
+		for(size_t type = 0; type < STRUCT_NROF; type++)
+		{
+			uint64_t mask = masks[type];
+			while(mask)
+			{
+				const size_t bitPos = pos + __builtin_ctzll(mask);
+				if(nullptr != keywords[type])
+				{
+					Verify((structural_t) type, content, size, bitPos);
+				}
+				else
+				{
+					Positions_[type].push_back(bitPos);
+				}
+
+				mask &= mask - 1; // clear lowest bit
+			}
+		}
+	}
+#endif // __AVX2__
+
+	ScalarClassify(content, size, pos, stop);
+}
+
+size_t StructuralIndex::Next(structural_t type, size_t offset) const
+{
+	const auto it = std::lower_bound(Positions_[type].begin(), Positions_[type].end(), offset);
+	if(Positions_[type].end() == it)
+	{
+		return SIZE_MAX;
+	}
+
+	return *it;
+}
+
+size_t StructuralIndex::CountBefore(structural_t type, size_t offset) const
+{
+	return std::lower_bound(Positions_[type].begin(), Positions_[type].end(), offset) - Positions_[type].begin();
+}
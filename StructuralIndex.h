@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef STRUCTURALINDEX_H_
+#define STRUCTURALINDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Positions of all structural characters / keywords of a netlist, found in one pass.
+// Uses AVX2 to classify 64 bytes at a time where available.
+class StructuralIndex {
+public:
+	typedef enum {
+		STRUCT_NON_BLOCKING, // "<="
+		STRUCT_ASSIGN, // "assign "
+		STRUCT_MODULE, // "module "
+		STRUCT_ENDMODULE, // "endmodule"
+		STRUCT_SEMICOLON, // ";"
+		STRUCT_ATTRIBUTE, // "(*"
+		STRUCT_BLOCK_COMMENT, // "/*"
+		STRUCT_LINE_COMMENT, // "//"
+		STRUCT_NEWLINE, // "\n"
+		STRUCT_QUOTE, // '"'
+		STRUCT_BACKSLASH, // "\", i.e. escaped identifiers
+		STRUCT_NROF
+	} structural_t;
+
+	int Create(const char * content, size_t size);
+
+	// Create for content arriving in parts, e.g. while it is decompressed
+	// content is everything so far and may move between calls, last once it is complete
+	void Extend(const char * content, size_t size, bool last);
+
+	const std::vector<size_t> &Positions(structural_t type) const { return Positions_[type]; }
+
+	// Returns first position >= offset or SIZE_MAX if there is none
+	size_t Next(structural_t type, size_t offset) const;
+
+	// Returns number of positions < offset, e.g. the line number - 1 for STRUCT_NEWLINE
+	size_t CountBefore(structural_t type, size_t offset) const;
+
+private:
+	std::vector<size_t> Positions_[STRUCT_NROF]; // sorted
+	size_t Indexed_ = 0; // content before is classified
+	bool Complete_ = false; // a further Extend starts over
+
+	static constexpr size_t Lookahead_ = 8; // chars after a position needed to classify it, i.e. of "endmodule"
+
+	void Clear();
+	void Classify(const char * content, size_t size, size_t start, size_t stop);
+	void ScalarClassify(const char * content, size_t size, size_t start, size_t stop);
+	void Verify(structural_t type, const char * content, size_t size, size_t pos);
+};
+
+#endif /* STRUCTURALINDEX_H_ */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "TextArena.h"
+
+// Moves the open string to a new chunk with room for size more bytes
+void TextArena::Grow(size_t size)
+{
+	const size_t chunkSize = std::max(ChunkSize_, 2 * (OpenSize_ + size));
+
+	Chunks_.emplace_back(new char[chunkSize]);
+	char * const chunk = Chunks_.back().get();
+
+	if(0 < OpenSize_)
+	{
+		memcpy(chunk, Open_, OpenSize_);
+	}
+
+	Open_ = chunk;
+	Free_ = chunkSize - OpenSize_;
+}
+
+void TextArena::Append(const char * str, size_t size)
+{
+	if(Measure_)
+	{
+		OpenSize_ += size;
+		return;
+	}
+
+	if(Free_ < size)
+	{
+		Grow(size);
+	}
+
+	memcpy(Open_ + OpenSize_, str, size);
+	OpenSize_ += size;
+	Free_ -= size;
+}
+
+void TextArena::Reserve(size_t size)
+{
+	if(!Measure_ && (Free_ < size))
+	{
+		Grow(size);
+	}
+}
+
+void TextArena::AppendNumber(size_t number)
+{
+	char digits[24];
+	const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+
+	Append(digits, result.ptr - digits);
+}
+
+std::string_view TextArena::Finish()
+{
+	Size_ += OpenSize_;
+	if(Measure_)
+	{
+		OpenSize_ = 0;
+		return std::string_view();
+	}
+
+	const std::string_view str(Open_, OpenSize_);
+
+	Open_ += OpenSize_;
+	OpenSize_ = 0;
+
+	return str;
+}
+
+void TextArena::Adopt(TextArena &&other)
+{
+	Size_ += other.Size_;
+
+	// Own open string stays where it is, an open string of other is dropped
+	for(auto &chunk: other.Chunks_)
+	{
+		Chunks_.push_back(std::move(chunk));
+	}
+
+	other.Chunks_.clear();
+	other.Open_ = nullptr;
+	other.OpenSize_ = 0;
+	other.Free_ = 0;
+	other.Size_ = 0;
+}
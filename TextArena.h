@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef TEXTARENA_H_
+#define TEXTARENA_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for generated text, e.g. replacements of diffs.
+// Text is appended to the open string at the end of the current chunk, finished strings never move.
+class TextArena {
+public:
+	void Append(const char * str, size_t size);
+	void Append(std::string_view str) { Append(str.data(), str.size()); }
+	void AppendNumber(size_t number);
+
+	// Closes the open string and returns it, valid as long as the arena or the arena adopting it lives
+	std::string_view Finish();
+
+	// Makes room for size more bytes, so appending them doesn't allocate, e.g. before a hot loop
+	void Reserve(size_t size);
+
+	// Takes over all chunks of other, strings finished in other stay valid
+	void Adopt(TextArena &&other);
+
+	size_t Size() const { return Size_; } // bytes of all finished strings
+
+	// Only counts the bytes appended, finished strings are empty, e.g. to predict the growth of a netlist
+	// To be set while the arena is empty
+	void MeasureSet(bool measure) { Measure_ = measure; }
+
+private:
+	static constexpr size_t ChunkSize_ = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>> Chunks_;
+	char * Open_ = nullptr; // start of open string in current chunk
+	size_t OpenSize_ = 0;
+	size_t Free_ = 0; // behind open string in current chunk
+	size_t Size_ = 0;
+	bool Measure_ = false;
+
+	void Grow(size_t size);
+};
+
+#endif /* TEXTARENA_H_ */
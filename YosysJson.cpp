@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "FiCache.h"
+
+#include "YosysJson.h"
+
+int YosysJson::Load(const std::string &fileName)
+{
+	Name_ = fileName;
+	Modules_.clear();
+
+	const int fd = open(fileName.c_str(), O_RDONLY);
+	if(0 > fd)
+	{
+		nfiError("Failed to open %s\n", fileName.c_str());
+		return -1;
+	}
+
+	Decompressor decompressor;
+	if(decompressor.Open(fd, Name_.c_str()))
+	{
+		nfiError("Decompressor open failed for %s\n", fileName.c_str());
+		close(fd);
+		return -1;
+	}
+
+	Decompressor_ = &decompressor;
+	Buffer_.resize(Compression::ChunkSize);
+	Pos_ = 0;
+	End_ = 0;
+	Offset_ = 0;
+
+	// Only the modules are of interest, e.g. not the creator
+	std::string key;
+	int ret = ObjectParse(&key, [&]() {
+		return (0 == key.compare("modules")) ? ModulesParse() : ValueSkip();
+	});
+
+	if(!ret && (-1 != Next()))
+	{
+		nfiError("Trailing characters\n");
+		ret = -1;
+	}
+
+	if(ret)
+	{
+		nfiError("Parsing %s failed at byte %lu\n", fileName.c_str(), Offset_ + Pos_);
+	}
+
+	Decompressor_ = nullptr;
+	Buffer_ = std::vector<char>();
+	close(fd);
+
+	nfiDebug("%lu modules in %s\n", Modules_.size(), fileName.c_str());
+
+	return ret;
+}
+
+const RtlFile::declarations_t * YosysJson::Declarations(std::string_view moduleName) const
+{
+	const auto it = Modules_.find(RtlFile::NetNameNormalize(moduleName));
+	if(Modules_.end() == it)
+	{
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+bool YosysJson::WidthsHash(std::string_view moduleName, uint64_t * hash) const
+{
+	const RtlFile::declarations_t * const declarations = Declarations(moduleName);
+	if(nullptr == declarations)
+	{
+		return false;
+	}
+
+	// Sum of the nets as the map order is arbitrary
+	uint64_t sum = 0;
+	for(const auto &net: *declarations)
+	{
+		uint64_t netHash = FiCache::Hash(net.first.data(), net.first.size());
+		netHash = FiCache::Hash(&net.second.Type, sizeof(net.second.Type), netHash);
+		netHash = FiCache::Hash(&net.second.Width, sizeof(net.second.Width), netHash);
+		netHash = FiCache::Hash(&net.second.ElemCnt, sizeof(net.second.ElemCnt), netHash);
+		sum += netHash;
+	}
+	*hash = sum;
+
+	return true;
+}
+
+int YosysJson::Refill()
+{
+	const ssize_t readRet = Decompressor_->Read(Buffer_.data(), Buffer_.size());
+	if(0 > readRet)
+	{
+		nfiError("Reading %s failed\n", Name_.c_str());
+		return -1;
+	}
+
+	Offset_ += End_;
+	Pos_ = 0;
+	End_ = readRet;
+
+	return (0 == readRet) ? -1 : 0;
+}
+
+int YosysJson::Peek()
+{
+	if((Pos_ == End_) && Refill())
+	{
+		return -1;
+	}
+
+	return (unsigned char) Buffer_[Pos_];
+}
+
+int YosysJson::Next()
+{
+	while(true)
+	{
+		const int c = Peek();
+		if((' ' != c) && ('\t' != c) && ('\n' != c) && ('\r' != c))
+		{
+			return c;
+		}
+
+		Pos_++;
+	}
+}
+
+int YosysJson::Expect(char c)
+{
+	if(c != Next())
+	{
+		nfiError("Expected '%c'\n", c);
+		return -1;
+	}
+
+	Pos_++;
+
+	return 0;
+}
+
+std::string_view YosysJson::Intern(const std::string &name)
+{
+	Names_.Append(name);
+	return Names_.Finish();
+}
+
+// Decodes escapes, \u only for ASCII as Yosys writes nothing else
+int YosysJson::StringGet(std::string * str)
+{
+	if(Expect('"'))
+	{
+		return -1;
+	}
+
+	if(nullptr != str)
+	{
+		str->clear();
+	}
+
+	while(true)
+	{
+		int c = Peek();
+		if(0 > c)
+		{
+			nfiError("String does not end\n");
+			return -1;
+		}
+
+		Pos_++;
+		if('"' == c)
+		{
+			return 0;
+		}
+
+		if('\\' == c)
+		{
+			c = Peek();
+			Pos_++;
+			switch(c)
+			{
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'n': c = '\n'; break;
+			case 'r': c = '\r'; break;
+			case 't': c = '\t'; break;
+
+			case 'u':
+			{
+				int code = 0;
+				for(size_t digit = 0; digit < 4; digit++)
+				{
+					const int hex = Peek();
+					Pos_++;
+					if(('0' <= hex) && (hex <= '9'))
+					{
+						code = 16 * code + hex - '0';
+					}
+					else if(('a' <= (hex | 0x20)) && ((hex | 0x20) <= 'f'))
+					{
+						code = 16 * code + (hex | 0x20) - 'a' + 10;
+					}
+					else
+					{
+						nfiError("Invalid \\u escape\n");
+						return -1;
+					}
+				}
+
+				if(0x7f < code)
+				{
+					nfiError("Non-ASCII \\u escape\n");
+					return -1;
+				}
+
+				c = code;
+			}
+				break;
+
+			case '"':
+			case '\\':
+			case '/':
+				break;
+
+			default:
+				nfiError("Invalid escape\n");
+				return -1;
+			}
+		}
+
+		if(nullptr != str)
+		{
+			str->push_back(c);
+		}
+	}
+}
+
+int YosysJson::NumberGet(size_t * number)
+{
+	if(('0' > Next()) || ('9' < Peek()))
+	{
+		nfiError("Expected a number\n");
+		return -1;
+	}
+
+	*number = 0;
+	for(int c = Peek(); ('0' <= c) && (c <= '9'); c = Peek())
+	{
+		*number = 10 * *number + c - '0';
+		Pos_++;
+	}
+
+	return 0;
+}
+
+// Skips any value, e.g. cells, attributes and parameters
+int YosysJson::ValueSkip()
+{
+	switch(Next())
+	{
+	case '{':
+	{
+		std::string key;
+		return ObjectParse(&key, [&]() { return ValueSkip(); });
+	}
+
+	case '[':
+		return ArrayParse([&]() { return ValueSkip(); });
+
+	case '"':
+		return StringGet(nullptr);
+
+	case -1:
+		nfiError("Value missing\n");
+		return -1;
+
+	default:
+		break;
+	}
+
+	// Numbers, true, false and null
+	for(int c = Peek(); (0 <= c) && (',' != c) && ('}' != c) && (']' != c) &&
+			(' ' != c) && ('\t' != c) && ('\n' != c) && ('\r' != c); c = Peek())
+	{
+		Pos_++;
+	}
+
+	return 0;
+}
+
+template<typename func_t>
+int YosysJson::ObjectParse(std::string * key, const func_t &func)
+{
+	if(Expect('{'))
+	{
+		return -1;
+	}
+
+	if('}' == Next())
+	{
+		Pos_++;
+		return 0;
+	}
+
+	while(true)
+	{
+		if(StringGet(key) || Expect(':') || func())
+		{
+			return -1;
+		}
+
+		const int c = Next();
+		Pos_++;
+		if('}' == c)
+		{
+			return 0;
+		}
+
+		if(',' != c)
+		{
+			nfiError("Expected ',' or '}' after %s\n", key->c_str());
+			return -1;
+		}
+	}
+}
+
+template<typename func_t>
+int YosysJson::ArrayParse(const func_t &func)
+{
+	if(Expect('['))
+	{
+		return -1;
+	}
+
+	if(']' == Next())
+	{
+		Pos_++;
+		return 0;
+	}
+
+	while(true)
+	{
+		if(func())
+		{
+			return -1;
+		}
+
+		const int c = Next();
+		Pos_++;
+		if(']' == c)
+		{
+			return 0;
+		}
+
+		if(',' != c)
+		{
+			nfiError("Expected ',' or ']'\n");
+			return -1;
+		}
+	}
+}
+
+int YosysJson::ModulesParse()
+{
+	std::string name;
+	std::string key;
+	return ObjectParse(&name, [&]() {
+		RtlFile::declarations_t * const declarations = &Modules_[Intern(name)];
+
+		// Cells are skipped, instances are taken from the Verilog
+		return ObjectParse(&key, [&]() {
+			if(0 == key.compare("netnames"))
+			{
+				return NetnamesParse(declarations);
+			}
+
+			if(0 == key.compare("memories"))
+			{
+				return MemoriesParse(declarations);
+			}
+
+			return ValueSkip();
+		});
+	});
+}
+
+// Net width is the number of its bits, whatever its range
+int YosysJson::NetnamesParse(RtlFile::declarations_t * declarations)
+{
+	std::string name;
+	std::string key;
+	return ObjectParse(&name, [&]() {
+		size_t width = 0;
+		if(ObjectParse(&key, [&]() {
+				return (0 == key.compare("bits")) ? ArrayParse([&]() { width++; return ValueSkip(); }) : ValueSkip();
+			}))
+		{
+			return -1;
+		}
+
+		if(0 == width)
+		{
+			nfiError("Net %s without bits\n", name.c_str());
+			return -1;
+		}
+
+		(*declarations)[Intern(name)] = {RtlFile::SIGNAL_TYPE_WIRE, width, 1};
+
+		return 0;
+	});
+}
+
+// Memories become arrays, e.g. "reg [3:0] mem [0:7]"
+int YosysJson::MemoriesParse(RtlFile::declarations_t * declarations)
+{
+	std::string name;
+	std::string key;
+	return ObjectParse(&name, [&]() {
+		size_t width = 0;
+		size_t size = 0;
+		if(ObjectParse(&key, [&]() {
+				if(0 == key.compare("width"))
+				{
+					return NumberGet(&width);
+				}
+
+				if(0 == key.compare("size"))
+				{
+					return NumberGet(&size);
+				}
+
+				return ValueSkip();
+			}))
+		{
+			return -1;
+		}
+
+		if((0 == width) || (0 == size))
+		{
+			nfiError("Memory %s without width or size\n", name.c_str());
+			return -1;
+		}
+
+		(*declarations)[Intern(name)] = {RtlFile::SIGNAL_TYPE_REG, width, size};
+
+		return 0;
+	});
+}
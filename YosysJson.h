@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef YOSYSJSON_H_
+#define YOSYSJSON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Compression.h"
+#include "RtlFile.h"
+#include "TextArena.h"
+
+// Net widths of a design as written by Yosys' write_json, instead of parsing the declarations of the Verilog.
+// The JSON is parsed in one pass while it is read, keeping only the widths of nets and memories per module.
+// Names are as in the JSON, i.e. escaped Verilog identifiers without '\', see RtlFile::NetNameNormalize.
+class YosysJson {
+public:
+	YosysJson() = default;
+
+	YosysJson & operator=(const YosysJson&) = delete;
+	YosysJson(const YosysJson &json) = delete;
+
+	// fileName may be compressed like netlists
+	int Load(const std::string &fileName);
+
+	// Of Verilog module name, nullptr if the JSON has no such module
+	const RtlFile::declarations_t * Declarations(std::string_view moduleName) const;
+
+	// Of all nets of the module for cache keys, false if the JSON has no such module
+	bool WidthsHash(std::string_view moduleName, uint64_t * hash) const;
+
+	const std::string &Name() const { return Name_; }
+
+private:
+	std::string Name_;
+
+	TextArena Names_; // of modules and nets, the maps point here
+	std::unordered_map<std::string_view, RtlFile::declarations_t> Modules_;
+
+	// Reader, only while loading
+	Decompressor * Decompressor_ = nullptr;
+	std::vector<char> Buffer_;
+	size_t Pos_ = 0;
+	size_t End_ = 0;
+	size_t Offset_ = 0; // of Buffer_ in the file, for errors
+
+	int Refill();
+	int Peek(); // next char, -1 at the end
+	int Next(); // next char after white space, -1 at the end
+	int Expect(char c);
+
+	std::string_view Intern(const std::string &name);
+
+	int StringGet(std::string * str); // nullptr skips it
+	int NumberGet(size_t * number);
+	int ValueSkip();
+
+	// Calls func() for each member of an object, with *key set to its name and the reader at its value
+	template<typename func_t>
+	int ObjectParse(std::string * key, const func_t &func);
+
+	// Calls func() for each element of an array, with the reader at it
+	template<typename func_t>
+	int ArrayParse(const func_t &func);
+
+	int ModulesParse();
+	int NetnamesParse(RtlFile::declarations_t * declarations);
+	int MemoriesParse(RtlFile::declarations_t * declarations);
+};
+
+#endif /* YOSYSJSON_H_ */
@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+// Generates Yosys-style netlists of configurable size and shape, to benchmark the fault injector
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef struct {
+	size_t Modules; // incl. top
+	size_t Depth; // hierarchy levels incl. top
+	size_t Assigns; // per module
+	size_t Instances; // per module above the lowest level
+	size_t Attributes; // percentage of declarations and statements preceded by an attribute
+	size_t SizeMb; // if non-zero, Modules is derived from it
+	size_t Seed;
+	std::string Top;
+	std::string Output; // stdout if empty
+} genConfig_t;
+
+static const size_t Width = 16;
+
+static void usagePrint(FILE * file, const char * name)
+{
+	fprintf(file, "Usage: %s [options]\n", name);
+	fprintf(file, "  -m, --modules <N>     Number of modules incl. top (default 100)\n");
+	fprintf(file, "  -d, --depth <N>       Hierarchy levels incl. top (default 4)\n");
+	fprintf(file, "  -a, --assigns <N>     Assignments per module (default 50)\n");
+	fprintf(file, "  -i, --instances <N>   Instances per module above the lowest level (default 2)\n");
+	fprintf(file, "  -p, --attributes <P>  Percentage of declarations and statements with attribute (default 50)\n");
+	fprintf(file, "  -s, --size <MB>       Approximate file size, sets the number of modules\n");
+	fprintf(file, "  -r, --seed <N>        Random seed (default 1)\n");
+	fprintf(file, "  -t, --top <name>      Name of top module (default top)\n");
+	fprintf(file, "  -o, --output <file>   Output file (default stdout)\n");
+	fprintf(file, "  -h, --help            Print this help\n");
+}
+
+static int sizeParse(size_t * out, const char * arg)
+{
+	char * end;
+	const long long value = strtoll(arg, &end, 10);
+	if((arg == end) || ('\0' != *end) || (0 > value))
+	{
+		fprintf(stderr, "Invalid number: %s\n", arg);
+		return -1;
+	}
+
+	*out = value;
+
+	return 0;
+}
+
+static int argParse(genConfig_t * config, int argc, char ** argv)
+{
+	static const struct option longOptions[] = {
+			{"modules", required_argument, nullptr, 'm'},
+			{"depth", required_argument, nullptr, 'd'},
+			{"assigns", required_argument, nullptr, 'a'},
+			{"instances", required_argument, nullptr, 'i'},
+			{"attributes", required_argument, nullptr, 'p'},
+			{"size", required_argument, nullptr, 's'},
+			{"seed", required_argument, nullptr, 'r'},
+			{"top", required_argument, nullptr, 't'},
+			{"output", required_argument, nullptr, 'o'},
+			{"help", no_argument, nullptr, 'h'},
+			{nullptr, 0, nullptr, 0}
+	};
+
+	*config = {100, 4, 50, 2, 50, 0, 1, "top", ""};
+
+	int opt;
+	while(-1 != (opt = getopt_long(argc, argv, "m:d:a:i:p:s:r:t:o:h", longOptions, nullptr)))
+	{
+		int ret = 0;
+		switch(opt)
+		{
+		case 'm': ret = sizeParse(&config->Modules, optarg); break;
+		case 'd': ret = sizeParse(&config->Depth, optarg); break;
+		case 'a': ret = sizeParse(&config->Assigns, optarg); break;
+		case 'i': ret = sizeParse(&config->Instances, optarg); break;
+		case 'p': ret = sizeParse(&config->Attributes, optarg); break;
+		case 's': ret = sizeParse(&config->SizeMb, optarg); break;
+		case 'r': ret = sizeParse(&config->Seed, optarg); break;
+		case 't': config->Top = optarg; break;
+		case 'o': config->Output = optarg; break;
+		case 'h':
+			usagePrint(stdout, argv[0]);
+			exit(0);
+		default:
+			usagePrint(stderr, argv[0]);
+			return -1;
+		}
+
+		if(ret)
+		{
+			usagePrint(stderr, argv[0]);
+			return -1;
+		}
+	}
+
+	if((optind != argc) || (0 == config->Depth) || (0 == config->Modules) || (100 < config->Attributes))
+	{
+		usagePrint(stderr, argv[0]);
+		return -1;
+	}
+
+	return 0;
+}
+
+class Generator {
+public:
+	explicit Generator(const genConfig_t &config) : Config_(config), Random_(config.Seed) {}
+
+	void Levels(size_t modules);
+	void Module(std::string * out, size_t id);
+
+	size_t Modules() const { return Level_.size(); }
+
+private:
+	const genConfig_t &Config_;
+	uint64_t Random_;
+
+	std::vector<size_t> Level_; // of each module id, top is id 0 on level 0
+	std::vector<size_t> LevelStart_; // first module id of each level, plus end
+
+	uint64_t Next();
+	bool Chance(size_t percent) { return Next() % 100 < percent; }
+	void Attribute(std::string * out, const char * indent, size_t line);
+	std::string Name(size_t id) const;
+	static std::string Wire(size_t nr);
+};
+
+// xorshift64, the same seed always gives the same netlist
+uint64_t Generator::Next()
+{
+	Random_ ^= Random_ << 13;
+	Random_ ^= Random_ >> 7;
+	Random_ ^= Random_ << 17;
+
+	return Random_;
+}
+
+// Top on level 0, the others spread evenly over the remaining levels
+void Generator::Levels(size_t modules)
+{
+	const size_t levels = (1 < modules) ? std::min(Config_.Depth, modules) : 1;
+
+	Level_.assign(1, 0);
+	LevelStart_.assign(1, 0);
+	for(size_t level = 1; level < levels; level++)
+	{
+		LevelStart_.push_back(Level_.size());
+
+		const size_t cnt = (modules - 1) / (levels - 1) + ((level - 1 < (modules - 1) % (levels - 1)) ? 1 : 0);
+		Level_.insert(Level_.end(), cnt, level);
+	}
+
+	LevelStart_.push_back(Level_.size());
+}
+
+void Generator::Attribute(std::string * out, const char * indent, size_t line)
+{
+	if(Chance(Config_.Attributes))
+	{
+		*out += indent;
+		*out += "(* src = \"bench.v:" + std::to_string(line) + "." + std::to_string(Next() % 80) + "-" +
+				std::to_string(line) + "." + std::to_string(Next() % 80) + "\" *)\n";
+	}
+}
+
+// Every fourth module is a parameterized one with an escaped name, as written by Yosys
+std::string Generator::Name(size_t id) const
+{
+	if(0 == id)
+	{
+		return Config_.Top;
+	}
+
+	if(0 == id % 4)
+	{
+		char name[128];
+		snprintf(name, sizeof(name), "\\$paramod\\mod%lu\\WIDTH=s32'%032lu ", id, Width);
+		return name;
+	}
+
+	return "mod" + std::to_string(id);
+}
+
+std::string Generator::Wire(size_t nr)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "_%04lu_", nr);
+
+	return name;
+}
+
+void Generator::Module(std::string * out, size_t id)
+{
+	const size_t assigns = std::max<size_t>(Config_.Assigns, 1);
+	const size_t level = Level_[id];
+	const bool hasChildren = (level + 1 < LevelStart_.size() - 1);
+	const size_t instances = hasChildren ? Config_.Instances : 0;
+	const std::string hi = std::to_string(Width - 1);
+	const std::string half = std::to_string(Width / 2);
+	const std::string halfHi = std::to_string(Width / 2 - 1);
+
+	*out += "\n";
+	if(0 == id)
+	{
+		*out += "(* top =  1  *)\n";
+	}
+	else
+	{
+		*out += "(* dynports =  1  *)\n";
+	}
+	*out += "(* src = \"bench.v:" + std::to_string(id) + ".1-" + std::to_string(id) + ".10\" *)\n";
+	*out += "module " + Name(id) + "(clk, in, out);\n";
+
+	Attribute(out, "  ", id);
+	*out += "  input clk;\n  wire clk;\n";
+	Attribute(out, "  ", id);
+	*out += "  input [" + hi + ":0] in;\n  wire [" + hi + ":0] in;\n";
+	Attribute(out, "  ", id);
+	*out += "  output [" + hi + ":0] out;\n  wire [" + hi + ":0] out;\n";
+	Attribute(out, "  ", id);
+	*out += "  reg [" + hi + ":0] q;\n";
+
+	for(size_t wire = 0; wire < assigns; wire++)
+	{
+		Attribute(out, "  ", id);
+		*out += "  wire [" + hi + ":0] " + Wire(wire) + ";\n";
+	}
+
+	for(size_t inst = 0; inst < instances; inst++)
+	{
+		*out += "  wire [" + hi + ":0] c" + std::to_string(inst) + "_out;\n";
+	}
+
+	// Mix of plain, part select and compound targets, one of them a non-blocking assignment
+	for(size_t wire = 0; wire < assigns; wire++)
+	{
+		const std::string target = Wire(wire);
+		const std::string source = (wire + 1 < assigns) ? Wire(wire + 1) :
+				((0 < instances) ? "c0_out" : "in");
+
+		if(0 == wire % 16)
+		{
+			*out += "  // " + target + " follows " + source + ", assign in a comment is no fault site\n";
+		}
+
+		Attribute(out, "  ", id);
+		switch(Next() % 4)
+		{
+		case 0:
+			*out += "  assign " + target + "[" + halfHi + ":0] = " + source + "[" + hi + ":" + half + "];\n";
+			break;
+
+		case 1:
+			*out += "  assign { " + target + "[" + hi + ":" + half + "], " + target + "[" + halfHi + ":0] } = { in[" +
+					halfHi + ":0], " + source + "[" + hi + ":" + half + "] };\n";
+			break;
+
+		default:
+			*out += "  assign " + target + " = " + source + " ^ in;\n";
+			break;
+		}
+	}
+
+	Attribute(out, "  ", id);
+	*out += "  always @(posedge clk)\n    q <= " + Wire(0) + ";\n";
+
+	// Children on the next level, round robin so every module is instantiated
+	const size_t childStart = hasChildren ? LevelStart_[level + 1] : 0;
+	const size_t childCnt = hasChildren ? LevelStart_[level + 2] - childStart : 0;
+	const size_t parentIndex = id - LevelStart_[level];
+	for(size_t inst = 0; inst < instances; inst++)
+	{
+		const size_t child = childStart + (parentIndex * instances + inst) % childCnt;
+
+		*out += "  (* module_not_derived = 32'd1 *)\n";
+		Attribute(out, "  ", id);
+		*out += "  " + Name(child) + " u" + std::to_string(inst) + " (\n";
+		*out += "    .clk(clk),\n";
+		*out += "    .in(q),\n";
+		*out += "    .out(c" + std::to_string(inst) + "_out)\n";
+		*out += "  );\n";
+	}
+
+	*out += "  assign out = q;\n";
+	*out += "endmodule\n";
+}
+
+int main(int argc, char ** argv)
+{
+	genConfig_t config;
+	if(argParse(&config, argc, argv))
+	{
+		return 1;
+	}
+
+	Generator generator(config);
+
+	// Module count for a target size, estimated from a module in the middle of the hierarchy
+	size_t modules = config.Modules;
+	if(0 != config.SizeMb)
+	{
+		generator.Levels(std::max<size_t>(config.Depth, 2));
+		std::string sample;
+		generator.Module(&sample, 1);
+
+		modules = std::max<size_t>(1, (config.SizeMb << 20) / sample.size());
+	}
+
+	generator.Levels(modules);
+
+	FILE * filep = config.Output.empty() ? stdout : fopen(config.Output.c_str(), "w");
+	if(nullptr == filep)
+	{
+		fprintf(stderr, "Failed to write-open %s\n", config.Output.c_str());
+		return 1;
+	}
+
+	std::string out = "/* Generated by Yosys 0.27 */\n";
+
+	// Lowest level first, like Yosys writes submodules before their parents
+	for(size_t id = generator.Modules(); id-- > 0;)
+	{
+		generator.Module(&out, id);
+
+		if((out.size() > (1 << 20)) || (0 == id))
+		{
+			if(out.size() != fwrite(out.data(), 1, out.size(), filep))
+			{
+				fprintf(stderr, "Writing failed\n");
+				return 1;
+			}
+
+			out.clear();
+		}
+	}
+
+	if((stdout != filep) && fclose(filep))
+	{
+		fprintf(stderr, "Closing %s failed\n", config.Output.c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -26,20 +26,39 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifndef NFI_DEBUG
 #define NFI_DEBUG 0
+#endif // NFI_DEBUG
 
-extern size_t nfiErrorCnt;
+// errors reported without diagnostics, inline as both libnetlistfi and the simulation runtime may be linked in
+inline size_t nfiErrorCnt = 0;
+
+#if NFI_DEBUG
+inline thread_local size_t nfiAllocCnt = 0; // operator new calls of the calling thread
+#endif // NFI_DEBUG
+
+// Destination of the errors and warnings of e.g. one Instrumenter
+typedef struct {
+	FILE * File;
+	size_t ErrorCnt; // incremented atomically, worker threads report as well
+} nfiDiagnostics_t;
+
+// Of the calling thread, threads started on its behalf take it over. nullptr for stderr and nfiErrorCnt.
+inline thread_local nfiDiagnostics_t * nfiDiagnostics = nullptr;
+
+#define nfiDiagnosticsFile() ((nullptr != nfiDiagnostics) ? nfiDiagnostics->File : stderr)
 
 #define nfiError(...) \
 		do { \
-			fprintf(stderr, "Error (%s:%i): ", __FILE__, __LINE__); \
+			FILE * const nfiFile = nfiDiagnosticsFile(); \
+			fprintf(nfiFile, "Error (%s:%i): ", __FILE__, __LINE__); \
 			if(errno) \
 			{ \
-				fprintf(stderr, "%s: ", strerror(errno)); \
+				fprintf(nfiFile, "%s: ", strerror(errno)); \
 			} \
-			fprintf(stderr, __VA_ARGS__); \
-			fflush(stderr); \
-			nfiErrorCnt++; \
+			fprintf(nfiFile, __VA_ARGS__); \
+			fflush(nfiFile); \
+			__atomic_fetch_add((nullptr != nfiDiagnostics) ? &nfiDiagnostics->ErrorCnt : &nfiErrorCnt, 1, __ATOMIC_RELAXED); \
 		} while(0)
 
 #define nfiFatal(...) \
@@ -54,11 +73,22 @@ extern size_t nfiErrorCnt;
 			exit(1); \
 		} while(0)
 
+// Like nfiError, but doesn't count as error
+#define nfiWarning(...) \
+		do { \
+			FILE * const nfiFile = nfiDiagnosticsFile(); \
+			fprintf(nfiFile, "Warning (%s:%i): ", __FILE__, __LINE__); \
+			fprintf(nfiFile, __VA_ARGS__); \
+			fflush(nfiFile); \
+		} while(0)
+
 #if NFI_DEBUG
+// Goes with the diagnostics, stdout may carry the netlist
 #define nfiDebug(...) \
 		do { \
-			printf(__VA_ARGS__); \
-			fflush(stdout); \
+			FILE * const nfiFile = nfiDiagnosticsFile(); \
+			fprintf(nfiFile, __VA_ARGS__); \
+			fflush(nfiFile); \
 		} while(0)
 #else // !NFI_DEBUG
 #define nfiDebug(...)
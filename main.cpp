@@ -18,59 +18,198 @@
  * SPDX-License-Identifier: LGPL-3.0-or-later
  */
 
-#include "RtlFile.h"
+#include <getopt.h>
+#include <stdlib.h>
 
-#include "common.h"
+#include <new>
+#include <thread>
 
-size_t nfiErrorCnt = 0;
+#include "Instrumenter.h"
 
-typedef struct {
-	std::string File;
-	std::string TopModule;
-} userConfig_t;
+#include "common.h"
 
-static int argParse(userConfig_t * config, int argc, char ** argv)
+#if NFI_DEBUG
+// Counts allocations, e.g. to check hot paths don't allocate
+// Not inlined, otherwise gcc pairs the inlined malloc with the free of delete and warns about a mismatch
+__attribute__((noinline)) void * operator new(size_t size)
 {
-	if(3 != argc)
+	nfiAllocCnt++;
+
+	void * ptr = malloc(size ? size : 1);
+	if(nullptr == ptr)
 	{
-		nfiError("No fileName / topModule supplied\n");
-		return -1;
+		throw std::bad_alloc();
 	}
 
-	config->File = argv[1];
-	config->TopModule = argv[2];
+	return ptr;
+}
 
-	return 0;
+__attribute__((noinline)) void * operator new[](size_t size)
+{
+	return operator new(size);
 }
 
-int main(int argc, char ** argv)
+__attribute__((noinline)) void operator delete(void * ptr) noexcept
 {
-	userConfig_t userConfig;
-	if(argParse(&userConfig, argc, argv))
-	{
-		nfiFatal("argParse failed\n");
-	}
+	free(ptr);
+}
 
-	// Get file
-	RtlFile rtlFile;
-	if(rtlFile.Get(userConfig.File.c_str(), userConfig.TopModule))
+__attribute__((noinline)) void operator delete(void * ptr, size_t size) noexcept
+{
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void * ptr) noexcept
+{
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void * ptr, size_t size) noexcept
+{
+	free(ptr);
+}
+#endif // NFI_DEBUG
+
+static constexpr size_t streamWindowMbDefault = 64;
+
+static void usagePrint(const char * name)
+{
+	fprintf(stderr, "Usage: %s [options] <fileName|directory|->... <topModule>\n", name);
+	fprintf(stderr, "  -j, --jobs <N>    Instrument modules with N threads, 0 for all cores (default 1)\n");
+	fprintf(stderr, "  -c, --cache <F>   Reuse instrumentation of unchanged modules from cache file F and update it\n");
+	fprintf(stderr, "  -t, --timing      Print time and throughput of each phase and the peak RSS\n");
+	fprintf(stderr, "  -p, --profile <F> Write a Chrome trace of phases, files and modules to F and print a summary\n");
+	fprintf(stderr, "  -s, --stream[=MB] Instrument window by window of MB megabytes (default %lu), for netlists larger than memory\n",
+			streamWindowMbDefault);
+	fprintf(stderr, "  -o, --output <P>  Write the netlist to file or directory P instead of back, - for stdout\n");
+	fprintf(stderr, "  -l, --library <F> Write the FiSignals library to F, - for stdout\n");
+	fprintf(stderr, "  -d, --drop-unreachable  Remove modules not instantiated below topModule instead of leaving them as they are\n");
+	fprintf(stderr, "  -a, --analyze     Print the fault space and the predicted growth as JSON instead of instrumenting\n");
+	fprintf(stderr, "  -y, --yosys-json <F>  Take net widths from F, written by Yosys' write_json, instead of the declarations\n");
+}
+
+static int argParse(Instrumenter::options_t * config, int argc, char ** argv)
+{
+	static const struct option longOptions[] = {
+			{"jobs", required_argument, nullptr, 'j'},
+			{"cache", required_argument, nullptr, 'c'},
+			{"timing", no_argument, nullptr, 't'},
+			{"profile", required_argument, nullptr, 'p'},
+			{"stream", optional_argument, nullptr, 's'},
+			{"output", required_argument, nullptr, 'o'},
+			{"library", required_argument, nullptr, 'l'},
+			{"drop-unreachable", no_argument, nullptr, 'd'},
+			{"analyze", no_argument, nullptr, 'a'},
+			{"yosys-json", required_argument, nullptr, 'y'},
+			{nullptr, 0, nullptr, 0}
+	};
+
+	int opt;
+	while(-1 != (opt = getopt_long(argc, argv, "j:c:tp:s::o:l:day:", longOptions, nullptr)))
 	{
-		nfiFatal("fileGet failed\n");
+		switch(opt)
+		{
+		case 'j':
+		{
+			char * end;
+			const long jobs = strtol(optarg, &end, 10);
+			if((optarg == end) || ('\0' != *end) || (0 > jobs))
+			{
+				nfiError("Invalid number of jobs: %s\n", optarg);
+				return -1;
+			}
+
+			config->Jobs = (0 == jobs) ? std::thread::hardware_concurrency() : jobs;
+			if(0 == config->Jobs)
+			{
+				config->Jobs = 1; // number of cores unknown
+			}
+		}
+			break;
+
+		case 'c':
+			config->CacheFile = optarg;
+			break;
+
+		case 't':
+			config->Timing = true;
+			break;
+
+		case 'p':
+			config->ProfileFile = optarg;
+			break;
+
+		case 's':
+		{
+			size_t windowMb = streamWindowMbDefault;
+			if(nullptr != optarg)
+			{
+				char * end;
+				const long mb = strtol(optarg, &end, 10);
+				if((optarg == end) || ('\0' != *end) || (0 >= mb))
+				{
+					nfiError("Invalid stream window size: %s\n", optarg);
+					return -1;
+				}
+
+				windowMb = mb;
+			}
+
+			config->StreamWindow = windowMb << 20;
+		}
+			break;
+
+		case 'o':
+			config->Output = optarg;
+			break;
+
+		case 'l':
+			config->Library = optarg;
+			break;
+
+		case 'd':
+			config->UnreachableDrop = true;
+			break;
+
+		case 'a':
+			config->Analyze = true;
+			break;
+
+		case 'y':
+			config->YosysJson = optarg;
+			break;
+
+		default:
+			usagePrint(argv[0]);
+			return -1;
+		}
 	}
 
-	if(rtlFile.FiSignalsCreate(RtlFile::FI_MODE_FLIP))
+	if(2 > argc - optind)
 	{
-		nfiFatal("Failed to insert FiSignals\n");
+		nfiError("No fileName / topModule supplied\n");
+		usagePrint(argv[0]);
+		return -1;
 	}
 
-	if(rtlFile.WriteBack())
+	config->Files.assign(argv + optind, argv + argc - 1);
+	config->TopModule = argv[argc - 1];
+
+	return Instrumenter::OptionsCheck(*config);
+}
+
+int main(int argc, char ** argv)
+{
+	Instrumenter::options_t options;
+	if(argParse(&options, argc, argv))
 	{
-		nfiFatal("WriteBack failed\n");
+		nfiFatal("argParse failed\n");
 	}
 
-	if(nfiErrorCnt)
+	Instrumenter instrumenter(options);
+	if(instrumenter.Run())
 	{
-		nfiFatal("There were %lu errors\n", nfiErrorCnt);
+		nfiFatal("Instrumentation failed with %lu errors\n", instrumenter.ErrorCnt());
 	}
 
 	return 0;
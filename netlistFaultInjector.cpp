@@ -22,43 +22,6 @@
 
 #include "netlistFaultInjector.hpp"
 
-size_t nfiErrorCnt = 0;
-
-int NetlistFaultInjector::ModuleFiBitsCnt(size_t * bits, size_t moduleIndex)
-{
-	const auto it = FiSignalCntCache_.find(moduleIndex);
-	if(FiSignalCntCache_.end() != it)
-	{
-		*bits =  it->second;
-		return 0;
-	}
-
-	*bits = 0;
-
-	// Cnt fi-signals in this module
-	for(const auto &signal: modules[moduleIndex].FiSignal)
-	{
-		*bits += signal.Width;
-	}
-
-	// Cnt fi-signals in instances of this module
-	for(const auto &inst: modules[moduleIndex].InstanceUuids)
-	{
-		size_t instBits = 0;
-		if(ModuleFiBitsCnt(&instBits, inst.first))
-		{
-			nfiError("ModuleFiBitsCnt failed\n");
-			return -1;
-		}
-
-		*bits += instBits;
-	}
-
-	FiSignalCntCache_[moduleIndex] = *bits;
-
-	return 0;
-}
-
 static size_t randUL()
 {
 	size_t ret;
@@ -74,13 +37,15 @@ static size_t randUL()
 
 int NetlistFaultInjector::Init()
 {
-	// Count all bits in all assignments in modules
-	if(ModuleFiBitsCnt(&FiBitCnt_, modulesTopIndex))
+	// Bits of all assignments below each module are counted by the injector
+	if((modulesFiBits.size() != modules.size()) || (modules.size() <= modulesTopIndex))
 	{
-		nfiError("ModuleFiBitsCnt failed\n");
+		nfiError("Library inconsistent, %lu modules but %lu bit counts\n", modules.size(), modulesFiBits.size());
 		return -1;
 	}
 
+	FiBitCnt_ = modulesFiBits[modulesTopIndex];
+
 	if(0 == FiBitCnt_)
 	{
 		nfiError("No fi signals\n");
@@ -88,11 +53,10 @@ int NetlistFaultInjector::Init()
 	}
 
 	nfiDebug("Counted %lu fi bits\n", FiBitCnt_);
-	nfiDebug("Cache:\n");
 #if NFI_DEBUG
-	for(const auto &mod: FiSignalCntCache_)
+	for(size_t module = 0; module < modules.size(); module++)
 	{
-		nfiDebug("%s: %lu\n", modules[mod.first].Name.c_str(), mod.second);
+		nfiDebug("%s: %lu\n", modules[module].Name.c_str(), modulesFiBits[module]);
 	}
 #endif // NFI_DEBUG
 
@@ -123,12 +87,7 @@ int NetlistFaultInjector::RandomFiGet(std::vector<uint16_t> * modInst, uint32_t
 	}
 
 	// How many bits in this module?
-	size_t bitsTotal = 0;
-	if(ModuleFiBitsCnt(&bitsTotal, moduleIndex))
-	{
-		nfiError("ModuleFiBitsCnt failed\n");
-		return -1;
-	}
+	const size_t bitsTotal = modulesFiBits[moduleIndex];
 
 	// Choose random bit
 	const size_t randomBit = randUL() % bitsTotal;
@@ -153,14 +112,7 @@ int NetlistFaultInjector::RandomFiGet(std::vector<uint16_t> * modInst, uint32_t
 	// Cnt fi-signals in instances of this module
 	for(const auto &inst: modules[moduleIndex].InstanceUuids)
 	{
-		size_t instBits = 0;
-		if(ModuleFiBitsCnt(&instBits, inst.first))
-		{
-			nfiError("ModuleFiBitsCnt failed\n");
-			return -1;
-		}
-
-		currentBit += instBits;
+		currentBit += modulesFiBits[inst.first];
 		if(randomBit < currentBit)
 		{
 			return RandomFiGet(modInst, assignNr, width, inst.first, inst.second);
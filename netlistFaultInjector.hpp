@@ -23,7 +23,6 @@
 
 #include <string>
 #include <vector>
-#include <map>
 
 	typedef enum {
 		SIGNAL_TYPE_WIRE,
@@ -48,6 +47,7 @@
 	} module_t;
 
 	extern const std::vector<module_t> modules;
+	extern const std::vector<size_t> modulesFiBits; // of each module and all instances below, indexed like modules
 	extern const size_t modulesTopIndex;
 	extern const size_t modulesTopUUID;
 
@@ -58,8 +58,6 @@
 
 
 	private:
-		std::map<size_t, size_t> FiSignalCntCache_; // <index, fi-signal cnt>
-		int ModuleFiBitsCnt(size_t * bits, size_t moduleIndex);
 		size_t FiBitCnt_ = 0;
 
 		int RandomFiGet(std::vector<uint16_t> * modInst, uint32_t * assignNr, size_t * width, size_t moduleIndex, uint16_t moduleUUID);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Instrumenter.h"
+
+// Instruments several netlists concurrently, one Instrumenter per thread, each run twice
+// Arguments are groups of <netlist> <topModule> <output> <library> <diagnostics> <streamWindow>
+// Prints the result and error count of each and the process wide error count, which must stay 0
+int main(int argc, char ** argv)
+{
+	static constexpr int argsPerRun = 6;
+	if((1 >= argc) || (0 != (argc - 1) % argsPerRun))
+	{
+		fprintf(stderr, "Usage: %s [<netlist> <topModule> <output> <library> <diagnostics> <streamWindow>]...\n", argv[0]);
+		return 1;
+	}
+
+	// New files of all threads are created with this umask
+	umask(027);
+
+	const size_t runsCnt = (argc - 1) / argsPerRun;
+	std::vector<FILE *> diagnostics(runsCnt);
+	std::vector<int> rets(runsCnt, 0);
+	std::vector<size_t> errorCnts(runsCnt);
+	std::vector<std::thread> threads;
+	for(size_t run = 0; run < runsCnt; run++)
+	{
+		char ** const args = argv + 1 + run * argsPerRun;
+
+		diagnostics[run] = fopen(args[4], "w");
+		if(nullptr == diagnostics[run])
+		{
+			fprintf(stderr, "Failed to open %s\n", args[4]);
+			return 1;
+		}
+
+		Instrumenter::options_t options;
+		options.Files = {args[0]};
+		options.TopModule = args[1];
+		options.Output = args[2];
+		options.Library = args[3];
+		options.StreamWindow = strtoul(args[5], nullptr, 10);
+		options.Jobs = 2;
+
+		threads.emplace_back([&, run, options]() {
+			Instrumenter instrumenter(options, diagnostics[run]);
+			for(size_t repeat = 0; repeat < 2; repeat++)
+			{
+				rets[run] |= instrumenter.Run();
+			}
+			errorCnts[run] = instrumenter.ErrorCnt();
+		});
+	}
+
+	for(auto &thread: threads)
+	{
+		thread.join();
+	}
+
+	for(size_t run = 0; run < runsCnt; run++)
+	{
+		fclose(diagnostics[run]);
+		printf("%lu: %i %lu\n", run, rets[run], errorCnts[run]);
+	}
+
+	printf("process: %lu\n", nfiErrorCnt);
+
+	return 0;
+}
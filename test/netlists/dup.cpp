@@ -0,0 +1,383 @@
+
+// Auto-generated file by HDFIT.NetlistFaultInjector for top module top
+
+#include "netlistFaultInjector.hpp"
+
+const std::vector<module_t> modules = {
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000000",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				2,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				3,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				4,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				5,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				6,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				7,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				8,
+			},
+		},
+		{
+		}
+	},
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000001",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				9,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				10,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				11,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				12,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				13,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				14,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				15,
+			},
+		},
+		{
+		}
+	},
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000002",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				16,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				17,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				18,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				19,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				20,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				21,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				22,
+			},
+		},
+		{
+		}
+	},
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000003",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				23,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				24,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				25,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				26,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				27,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				28,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				29,
+			},
+		},
+		{
+		}
+	},
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000004",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				30,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				31,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				32,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				33,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				34,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				35,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				36,
+			},
+		},
+		{
+		}
+	},
+	{
+		"\\$paramod\\leaf\\W=s32'00000000000000000000000000000005",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				2,
+				1,
+				37,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				4,
+				1,
+				38,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				39,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				40,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				6,
+				1,
+				41,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				42,
+			},
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				43,
+			},
+		},
+		{
+		}
+	},
+	{
+		"midA",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				44,
+			},
+		},
+		{
+			{1, 48},
+			{2, 49},
+		}
+	},
+	{
+		"midB",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				45,
+			},
+		},
+		{
+			{1, 50},
+			{2, 51},
+		}
+	},
+	{
+		"midC",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				46,
+			},
+		},
+		{
+			{3, 52},
+			{4, 53},
+		}
+	},
+	{
+		"top",
+		{
+			{
+				SIGNAL_TYPE_WIRE,
+				8,
+				1,
+				47,
+			},
+		},
+		{
+			{0, 54},
+			{3, 55},
+			{5, 56},
+			{6, 57},
+			{7, 58},
+			{8, 59},
+		}
+	},
+}; // modules
+
+const std::vector<size_t> modulesFiBits = {
+	42,
+	42,
+	42,
+	42,
+	42,
+	42,
+	92,
+	92,
+	92,
+	410,
+}; // modulesFiBits
+
+const size_t modulesTopIndex = 9;
+
+const size_t modulesTopUUID = 1;
+
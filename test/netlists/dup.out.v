@@ -0,0 +1,292 @@
+/* Generated by Yosys 0.27 */
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000000 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] & _001_[1:0]) ^ ((fiEnable && (2 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] & _002_[3:0]) ^ ((fiEnable && (3 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] & _003_[5:0]) ^ ((fiEnable && (4 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] & _000_[7:0]) ^ ((fiEnable && (5 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (6 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (7 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (8 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000001 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] ^ _001_[1:0]) ^ ((fiEnable && (9 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] ^ _002_[3:0]) ^ ((fiEnable && (10 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] ^ _003_[5:0]) ^ ((fiEnable && (11 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] ^ _000_[7:0]) ^ ((fiEnable && (12 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (13 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (14 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (15 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000002 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] ^ _001_[1:0]) ^ ((fiEnable && (16 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] ^ _002_[3:0]) ^ ((fiEnable && (17 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] ^ _003_[5:0]) ^ ((fiEnable && (18 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] ^ _000_[7:0]) ^ ((fiEnable && (19 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (20 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (21 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (22 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000003 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] & _001_[1:0]) ^ ((fiEnable && (23 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] & _002_[3:0]) ^ ((fiEnable && (24 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] & _003_[5:0]) ^ ((fiEnable && (25 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] & _000_[7:0]) ^ ((fiEnable && (26 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (27 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (28 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (29 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000004 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] ^ _001_[1:0]) ^ ((fiEnable && (30 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] ^ _002_[3:0]) ^ ((fiEnable && (31 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] ^ _003_[5:0]) ^ ((fiEnable && (32 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] ^ _000_[7:0]) ^ ((fiEnable && (33 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (34 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (35 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (36 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000005 (clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ =( x[1:0] ^ _001_[1:0]) ^ ((fiEnable && (37 == top.GlobalFiNumber)) ? top.GlobalFiSignal[1:0] : {2{1'b0}});
+  assign _001_ =( x[3:0] ^ _002_[3:0]) ^ ((fiEnable && (38 == top.GlobalFiNumber)) ? top.GlobalFiSignal[3:0] : {4{1'b0}});
+  assign _002_ =( x[5:0] ^ _003_[5:0]) ^ ((fiEnable && (39 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  assign _003_ =( x[7:0] ^ _000_[7:0]) ^ ((fiEnable && (40 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign { _000_, _001_ } =( x[2:0]) ^ ((fiEnable && (41 == top.GlobalFiNumber)) ? top.GlobalFiSignal[5:0] : {6{1'b0}});
+  always @(posedge clk)
+    r <=( x) ^ ((fiEnable && (42 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  assign y =( r) ^ ((fiEnable && (43 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midA(clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y =( t ^ x) ^ ((fiEnable && (44 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  \$paramod\leaf\W=s32'00000000000000000000000000000001  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((48 == top.GlobalFiModInstNr[0]) || (48 == top.GlobalFiModInstNr[1]) || (48 == top.GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000002  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((49 == top.GlobalFiModInstNr[0]) || (49 == top.GlobalFiModInstNr[1]) || (49 == top.GlobalFiModInstNr[2])))
+  );
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midB(clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y =( t ^ x) ^ ((fiEnable && (45 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  \$paramod\leaf\W=s32'00000000000000000000000000000001  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((50 == top.GlobalFiModInstNr[0]) || (50 == top.GlobalFiModInstNr[1]) || (50 == top.GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000002  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((51 == top.GlobalFiModInstNr[0]) || (51 == top.GlobalFiModInstNr[1]) || (51 == top.GlobalFiModInstNr[2])))
+  );
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midC(clk, x, y, fiEnable);
+ input fiEnable;
+ wire fiEnable;
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y =( t ^ x) ^ ((fiEnable && (46 == top.GlobalFiNumber)) ? top.GlobalFiSignal[7:0] : {8{1'b0}});
+  \$paramod\leaf\W=s32'00000000000000000000000000000003  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((52 == top.GlobalFiModInstNr[0]) || (52 == top.GlobalFiModInstNr[1]) || (52 == top.GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000004  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t),
+    .fiEnable(fiEnable && ((53 == top.GlobalFiModInstNr[0]) || (53 == top.GlobalFiModInstNr[1]) || (53 == top.GlobalFiModInstNr[2])))
+  );
+endmodule
+
+(* top =  1  *)
+module top(clk, x, y, GlobalFiSignal, GlobalFiNumber, GlobalFiModInstNr);
+input GlobalFiSignal;
+wire [7:0] GlobalFiSignal;
+input GlobalFiNumber;
+wire [31:0] GlobalFiNumber;
+input GlobalFiModInstNr;
+wire [15:0] GlobalFiModInstNr[3];
+wire fiEnable;
+assign fiEnable = (1 == GlobalFiModInstNr[0]) || (1 == GlobalFiModInstNr[1]) || (1 == GlobalFiModInstNr[2]);
+
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] m;
+  assign y =( m) ^ ((fiEnable && (47 == GlobalFiNumber)) ? GlobalFiSignal[7:0] : {8{1'b0}});
+  midA  m0 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((57 == GlobalFiModInstNr[0]) || (57 == GlobalFiModInstNr[1]) || (57 == GlobalFiModInstNr[2])))
+  );
+  midB  m1 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((58 == GlobalFiModInstNr[0]) || (58 == GlobalFiModInstNr[1]) || (58 == GlobalFiModInstNr[2])))
+  );
+  midC  m2 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((59 == GlobalFiModInstNr[0]) || (59 == GlobalFiModInstNr[1]) || (59 == GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000000  l0 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((54 == GlobalFiModInstNr[0]) || (54 == GlobalFiModInstNr[1]) || (54 == GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000005  l1 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((56 == GlobalFiModInstNr[0]) || (56 == GlobalFiModInstNr[1]) || (56 == GlobalFiModInstNr[2])))
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000003  l2 (
+    .clk(clk),
+    .x(x),
+    .y(m),
+    .fiEnable(fiEnable && ((55 == GlobalFiModInstNr[0]) || (55 == GlobalFiModInstNr[1]) || (55 == GlobalFiModInstNr[2])))
+  );
+endmodule
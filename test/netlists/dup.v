@@ -0,0 +1,253 @@
+/* Generated by Yosys 0.27 */
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000000 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] & _001_[1:0];
+  assign _001_ = x[3:0] & _002_[3:0];
+  assign _002_ = x[5:0] & _003_[5:0];
+  assign _003_ = x[7:0] & _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000001 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] ^ _001_[1:0];
+  assign _001_ = x[3:0] ^ _002_[3:0];
+  assign _002_ = x[5:0] ^ _003_[5:0];
+  assign _003_ = x[7:0] ^ _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000002 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] ^ _001_[1:0];
+  assign _001_ = x[3:0] ^ _002_[3:0];
+  assign _002_ = x[5:0] ^ _003_[5:0];
+  assign _003_ = x[7:0] ^ _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000003 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] & _001_[1:0];
+  assign _001_ = x[3:0] & _002_[3:0];
+  assign _002_ = x[5:0] & _003_[5:0];
+  assign _003_ = x[7:0] & _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000004 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] ^ _001_[1:0];
+  assign _001_ = x[3:0] ^ _002_[3:0];
+  assign _002_ = x[5:0] ^ _003_[5:0];
+  assign _003_ = x[7:0] ^ _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* dynports =  1  *)
+(* src = "leaf.v:1.1-20.10" *)
+module \$paramod\leaf\W=s32'00000000000000000000000000000005 (clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  reg [7:0] r;
+  wire [1:0] _000_;
+  wire [3:0] _001_;
+  wire [5:0] _002_;
+  wire [7:0] _003_;
+  assign _000_ = x[1:0] ^ _001_[1:0];
+  assign _001_ = x[3:0] ^ _002_[3:0];
+  assign _002_ = x[5:0] ^ _003_[5:0];
+  assign _003_ = x[7:0] ^ _000_[7:0];
+  assign { _000_, _001_ } = x[2:0];
+  always @(posedge clk)
+    r <= x;
+  assign y = r;
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midA(clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y = t ^ x;
+  \$paramod\leaf\W=s32'00000000000000000000000000000001  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000002  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midB(clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y = t ^ x;
+  \$paramod\leaf\W=s32'00000000000000000000000000000001  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000002  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+endmodule
+
+(* src = "mid.v:1.1-30.10" *)
+module midC(clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] t;
+  assign y = t ^ x;
+  \$paramod\leaf\W=s32'00000000000000000000000000000003  u0 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000004  u1 (
+    .clk(clk),
+    .x(x),
+    .y(t)
+  );
+endmodule
+
+(* top =  1  *)
+module top(clk, x, y);
+  input clk;
+  wire clk;
+  input [7:0] x;
+  wire [7:0] x;
+  output [7:0] y;
+  wire [7:0] y;
+  wire [7:0] m;
+  assign y = m;
+  midA  m0 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+  midB  m1 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+  midC  m2 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000000  l0 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000005  l1 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+  \$paramod\leaf\W=s32'00000000000000000000000000000003  l2 (
+    .clk(clk),
+    .x(x),
+    .y(m)
+  );
+endmodule
@@ -0,0 +1,116 @@
+/* Generated by Yosys 0.27+3 (git sha1 e1a8f2e1c, gcc 12.2.0 -fPIC -Os) */
+
+(* dynports =  1  *)
+(* src = "JmsFlipFlop.v:1.1-15.10" *)
+module \$paramod\jmsslaveflipflop\WIDTH=s32'00000000000000000000000000000100 (clk, \in , out);
+  (* src = "JmsFlipFlop.v:5.14-5.17" *)
+  input clk;
+  wire clk;
+  (* src = "JmsFlipFlop.v:6.20-6.22" *)
+  input [3:0] \in ;
+  wire [3:0] \in ;
+  (* src = "JmsFlipFlop.v:7.21-7.24" *)
+  output [3:0] out;
+  reg [3:0] out;
+  (* src = "JmsFlipFlop.v:10.4-13.8" *)
+  always @(posedge clk)
+    out <= \in ;
+endmodule
+
+(* dynports =  1  *)
+(* src = "JmsFlipFlop.v:17.1-40.10" *)
+module \$paramod\JmsFlipFlop\WIDTH=s32'00000000000000000000000000000100 (clk, \in , out);
+  (* src = "JmsFlipFlop.v:25.14-25.17" *)
+  input clk;
+  wire clk;
+  (* src = "JmsFlipFlop.v:32.4-32.8" *)
+  wire iclk;
+  (* src = "JmsFlipFlop.v:26.20-26.22" *)
+  input [3:0] \in ;
+  wire [3:0] \in ;
+  (* src = "JmsFlipFlop.v:33.22-33.31" *)
+  wire [3:0] masterOut;
+  (* src = "JmsFlipFlop.v:27.21-27.24" *)
+  output [3:0] out;
+  wire [3:0] out;
+  // inverted clock: iclk <= not used here
+  assign iclk = ~clk;
+  (* module_not_derived = 32'd1 *)
+  (* src = "JmsFlipFlop.v:38.38-38.70" *)
+  \$paramod\jmsslaveflipflop\WIDTH=s32'00000000000000000000000000000100  dflop_instM (
+    .clk(clk),
+    .\in (\in ),
+    .out(masterOut)
+  );
+  (* module_not_derived = 32'd1 *)
+  (* src = "JmsFlipFlop.v:39.38-39.71" *)
+  \$paramod\jmsslaveflipflop\WIDTH=s32'00000000000000000000000000000100  dflop_instS (
+    .clk(iclk),
+    .\in (masterOut),
+    .out(out)
+  );
+endmodule
+
+/* assign commented = out; module fake(a); endmodule */
+(* top =  1  *)
+(* src = "fma.v:1.1-40.10" *)
+module fma(a, b, c, d, clk);
+  wire _000_;
+  wire _001_;
+  wire _002_;
+  wire _003_;
+  wire [1:0] _004_;
+  wire _005_;
+  (* src = "fma.v:3.21-3.22" *)
+  input [3:0] a;
+  wire [3:0] a;
+  (* src = "fma.v:4.21-4.22" *)
+  input [3:0] b;
+  wire [3:0] b;
+  (* src = "fma.v:5.21-5.22" *)
+  input [3:0] c;
+  wire [3:0] c;
+  (* src = "fma.v:9.14-9.19" *)
+  wire [3:0] cStg2;
+  (* src = "fma.v:8.14-8.17" *)
+  input clk;
+  wire clk;
+  (* src = "fma.v:6.21-6.22" *)
+  output [3:0] d;
+  wire [3:0] d;
+  (* src = "fma.v:10.14-10.17" *)
+  wire [3:0] mul;
+  (* src = "fma.v:12.14-12.21" *)
+  wire [3:0] mulStg2;
+  wire \dbg.sig ;
+  reg [3:0] mem [0:3];
+  reg [7:0] acc;
+  assign _000_ = a[0] & b[1];
+  assign _001_ = a[1] & b[0];
+  assign _002_ = _000_ ^ _001_;
+  assign _003_ = a[0] & b[0]; // assign fake = 1;
+  assign _004_ = { _003_, _002_ };
+  assign { _005_, \dbg.sig  } = { a[3], b[3] };
+  assign mul[1:0] = _004_;
+  assign mul[3:2] = a[3:2] ^ b[3:2];
+  (* src = "fma.v:20.3-20.30" *)
+  always @(posedge clk)
+    mem[1] <= a;
+  always @(posedge clk)
+    acc[3:0] <= { _005_, _003_, _002_, \dbg.sig  };
+  (* module_not_derived = 32'd1 *)
+  (* src = "fma.v:15.4-15.34" *)
+  \$paramod\JmsFlipFlop\WIDTH=s32'00000000000000000000000000000100  msff_inst15 (
+    .clk(clk),
+    .\in (mul),
+    .out(mulStg2)
+  );
+  (* module_not_derived = 32'd1 *)
+  (* src = "fma.v:18.4-18.28" *)
+  \$paramod\JmsFlipFlop\WIDTH=s32'00000000000000000000000000000100  msff_inst18 (
+    .clk(clk),
+    .\in (c),
+    .out(cStg2)
+  );
+  assign d = mulStg2 + cStg2;
+endmodule
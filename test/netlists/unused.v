@@ -0,0 +1,15 @@
+
+module unused(clk, a, y);
+  input clk;
+  wire clk;
+  input [3:0] a;
+  wire [3:0] a;
+  output [3:0] y;
+  wire [3:0] y;
+  assign y = ~a;
+  \$paramod\jmsslaveflipflop\WIDTH=s32'00000000000000000000000000000100  unused_inst (
+    .clk(clk),
+    .\in (a),
+    .out(y)
+  );
+endmodule